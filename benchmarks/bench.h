@@ -0,0 +1,52 @@
+#ifndef LIBBECH32_BENCH_H
+#define LIBBECH32_BENCH_H
+
+// Minimal timing helpers shared by the benchmark programs. Each benchmark is run
+// repeatedly until at least minSeconds has passed, then the time per call (and the
+// throughput, when the number of bytes processed per call is given) is printed.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace bench {
+
+    const double minSeconds = 0.25;
+
+    // results are folded into this so the compiler can't discard the benchmarked work
+    static volatile uint64_t sink;
+
+    template<typename T>
+    void keep(const T & value) {
+        sink = sink + static_cast<uint64_t>(value);
+    }
+
+    // run f() until minSeconds has passed and print the average time per call
+    template<typename F>
+    void run(const std::string & name, size_t bytesPerCall, F f) {
+        typedef std::chrono::steady_clock clock;
+        uint64_t calls = 0;
+        uint64_t batch = 1;
+        double elapsed = 0;
+        clock::time_point start = clock::now();
+        while (elapsed < minSeconds) {
+            for (uint64_t i = 0; i < batch; ++i)
+                f();
+            calls += batch;
+            batch *= 2;
+            elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        }
+        double nsPerCall = elapsed * 1e9 / static_cast<double>(calls);
+        if (bytesPerCall > 0) {
+            double mbPerSecond = static_cast<double>(bytesPerCall) * static_cast<double>(calls) / elapsed / 1e6;
+            std::printf("%-48s %12.1f ns/call %10.1f MB/s\n", name.c_str(), nsPerCall, mbPerSecond);
+        }
+        else {
+            std::printf("%-48s %12.1f ns/call\n", name.c_str(), nsPerCall);
+        }
+    }
+
+}
+
+#endif // LIBBECH32_BENCH_H
@@ -0,0 +1,56 @@
+// Benchmarks for raw base32 in the bech32 alphabet over multi-megabyte buffers, compared
+// with regrouping a bit at a time as convertbits() in BIP-0173 does.
+
+#include "bech32_base32.h"
+#include "bench.h"
+
+#include <random>
+
+namespace {
+
+    // convertbits(data, 8, 5, pad=true) followed by a charset lookup per value
+    std::string convertBitsEncode(const std::vector<unsigned char> &data) {
+        static const char charset[] = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
+        std::string ret;
+        ret.reserve((8 * data.size() + 4) / 5);
+        uint32_t acc = 0;
+        unsigned bits = 0;
+        for (unsigned char byte : data) {
+            acc = (acc << 8u | byte) & 0xfffu;
+            bits += 8;
+            while (bits >= 5) {
+                bits -= 5;
+                ret += charset[(acc >> bits) & 31u];
+            }
+        }
+        if (bits != 0)
+            ret += charset[(acc << (5 - bits)) & 31u];
+        return ret;
+    }
+
+}
+
+int main() {
+    const size_t sizes[] = {1000, 4u << 20u};
+
+    for (size_t size : sizes) {
+        std::string n = std::to_string(size);
+        std::mt19937 rng(static_cast<std::mt19937::result_type>(size));
+        std::vector<unsigned char> data(size);
+        for (unsigned char &byte : data)
+            byte = static_cast<unsigned char>(rng());
+        std::string chars = bech32::encodeBase32(data);
+
+        bench::run("encodeBase32 " + n, size, [&] {
+            bench::keep(bech32::encodeBase32(data).size());
+        });
+        bench::run("convertbits encode " + n, size, [&] {
+            bench::keep(convertBitsEncode(data).size());
+        });
+        bench::run("decodeBase32 " + n, size, [&] {
+            bench::keep(bech32::decodeBase32(chars).size());
+        });
+    }
+
+    return 0;
+}
@@ -0,0 +1,72 @@
+// Benchmarks for canonicalizing and deduplicating many bech32 strings: AddressDeduplicator,
+// in memory and spilling runs to temporary files, compared with decoding and re-encoding
+// each string into a std::unordered_set.
+
+#include "bech32.h"
+#include "bech32_canonical.h"
+#include "bench.h"
+
+#include <random>
+#include <unordered_set>
+
+namespace {
+
+    // segwit v0 sized strings, a quarter of them duplicates in upper case
+    std::vector<std::string> randomAddresses(size_t n) {
+        std::mt19937 rng(static_cast<std::mt19937::result_type>(n));
+        std::vector<std::string> ret;
+        for (size_t i = 0; i < n; ++i) {
+            if (i % 4 == 3) {
+                std::string dup = ret[rng() % ret.size()];
+                for (char &c : dup)
+                    c = static_cast<char>(::toupper(c));
+                ret.push_back(dup);
+                continue;
+            }
+            std::vector<unsigned char> dp(33);
+            for (unsigned char &v : dp)
+                v = static_cast<unsigned char>(rng() % 32);
+            dp[0] = 0;
+            ret.push_back(bech32::encodeUsingOriginalConstant("bc", dp));
+        }
+        return ret;
+    }
+
+    void runDeduplicator(const std::vector<std::string> &addresses, const bech32::CanonicalizeOptions &options) {
+        bech32::AddressDeduplicator deduplicator(options);
+        for (const std::string &address : addresses)
+            deduplicator.add(address);
+        size_t bytes = 0;
+        deduplicator.finish([&bytes](const std::string &bstring) { bytes += bstring.size(); });
+        bench::keep(bytes);
+    }
+
+}
+
+int main() {
+    const size_t counts[] = {100000, 1000000};
+
+    for (size_t count : counts) {
+        std::string n = std::to_string(count);
+        std::vector<std::string> addresses = randomAddresses(count);
+
+        bech32::CanonicalizeOptions options;
+        bench::run("deduplicator in memory " + n, 0, [&] {
+            runDeduplicator(addresses, options);
+        });
+        options.memoryLimit = 1 << 20;
+        bench::run("deduplicator with 1MB runs " + n, 0, [&] {
+            runDeduplicator(addresses, options);
+        });
+        bench::run("decode, encode and unordered_set " + n, 0, [&] {
+            std::unordered_set<std::string> set;
+            for (const std::string &address : addresses) {
+                bech32::DecodedResult decoded = bech32::decode(address);
+                set.insert(bech32::encodeUsingOriginalConstant(decoded.hrp, decoded.dp));
+            }
+            bench::keep(set.size());
+        });
+    }
+
+    return 0;
+}
@@ -0,0 +1,53 @@
+// Benchmarks for the checksum (polymod) calculation, on inputs longer than a standard
+// bech32 string allows.
+
+#include "bech32_checksum.h"
+#include "bench.h"
+
+#include <random>
+#include <thread>
+
+namespace {
+
+    std::vector<unsigned char> randomValues(size_t n) {
+        std::mt19937 rng(static_cast<std::mt19937::result_type>(n));
+        std::uniform_int_distribution<int> dist(0, 31);
+        std::vector<unsigned char> ret(n);
+        for (unsigned char &v : ret)
+            v = static_cast<unsigned char>(dist(rng));
+        return ret;
+    }
+
+}
+
+template<typename G>
+void runPolymodBenchmarks(const std::string &name, const std::vector<unsigned char> &values) {
+    const unsigned char *first = values.data();
+    const unsigned char *last = first + values.size();
+    std::string n = std::to_string(values.size());
+
+    bench::run(name + " serial " + n, values.size(), [&] {
+        bench::keep(G::serial(first, last, 1));
+    });
+    bench::run(name + " folded " + n, values.size(), [&] {
+        bench::keep(G::folded(first, last, 1));
+    });
+    bench::run(name + " interleaved " + n, values.size(), [&] {
+        bench::keep(G::interleaved(first, last, 1));
+    });
+    bench::run(name + " chunked " + n, values.size(), [&] {
+        bench::keep(G::chunked(first, last, 1, std::thread::hardware_concurrency()));
+    });
+}
+
+int main() {
+    const size_t lengths[] = {90, 256, 1000, 4096, 10000, 65536, 100000};
+
+    for (size_t n : lengths) {
+        std::vector<unsigned char> values = randomValues(n);
+        runPolymodBenchmarks<bech32::Bech32Generator>("bech32", values);
+        runPolymodBenchmarks<bech32::Blech32Generator>("blech32", values);
+    }
+
+    return 0;
+}
@@ -0,0 +1,52 @@
+// Benchmarks for decoding a column of strings in Arrow's layout (offsets and contiguous
+// bytes) into columns of results, compared with decoding each string on its own.
+
+#include "bech32.h"
+#include "bech32_columnar.h"
+#include "bench.h"
+
+#include <random>
+
+int main() {
+    const size_t count = 100000;
+    std::mt19937 rng(static_cast<std::mt19937::result_type>(count));
+    std::vector<int32_t> offsets(1, 0);
+    std::string data;
+    for (size_t i = 0; i < count; ++i) {
+        std::vector<unsigned char> dp(33);
+        for (unsigned char &v : dp)
+            v = static_cast<unsigned char>(rng() % 32);
+        dp[0] = 0;
+        data += bech32::encodeUsingOriginalConstant(i % 2 ? "bc" : "tb", dp);
+        offsets.push_back(static_cast<int32_t>(data.size()));
+    }
+    bech32::StringColumn column = {offsets.data(), data.data(), count};
+    bech32::HrpRegistry registry({"bc", "tb"});
+    std::string n = std::to_string(count);
+
+    std::vector<uint8_t> validity((count + 7) / 8);
+    std::vector<uint8_t> encodings(count);
+    std::vector<bech32::HrpId> hrpIds(count);
+    std::vector<int32_t> dataLengths(count);
+    std::vector<int32_t> dataOffsets(count + 1);
+    std::vector<unsigned char> packed(data.size());
+    bech32::DecodedColumns out = {validity.data(), encodings.data(), hrpIds.data(), dataLengths.data(),
+                                  dataOffsets.data(), packed.data()};
+
+    bench::run("decodeColumn " + n, data.size(), [&] {
+        bench::keep(bech32::decodeColumn(column, registry, out));
+    });
+    bench::run("validateColumn " + n, data.size(), [&] {
+        bench::keep(bech32::validateColumn(column, validity.data(), encodings.data()));
+    });
+    bench::run("decode each string " + n, data.size(), [&] {
+        size_t valid = 0;
+        for (size_t i = 0; i < count; ++i) {
+            std::string bstr(data.data() + offsets[i], data.data() + offsets[i + 1]);
+            valid += bech32::decode(bstr, registry).encoding != bech32::Encoding::Invalid;
+        }
+        bench::keep(valid);
+    });
+
+    return 0;
+}
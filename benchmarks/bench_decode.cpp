@@ -0,0 +1,105 @@
+// Benchmarks for decoding bech32 strings with each of the decode modes. The cheaper modes
+// skip checks that are redundant for strings that were validated when they were stored.
+
+#include "bech32.h"
+#include "bech32_cache.h"
+#include "bench.h"
+
+#include <random>
+
+namespace {
+
+    std::vector<unsigned char> randomValues(size_t n) {
+        std::mt19937 rng(static_cast<std::mt19937::result_type>(n));
+        std::uniform_int_distribution<int> dist(0, 31);
+        std::vector<unsigned char> ret(n);
+        for (unsigned char &v : ret)
+            v = static_cast<unsigned char>(dist(rng));
+        return ret;
+    }
+
+}
+
+void runDecodeBenchmarks(const std::string &bstr) {
+    std::string n = std::to_string(bstr.size());
+
+    bench::run("decode full " + n, bstr.size(), [&] {
+        bench::keep(bech32::decode(bstr, bech32::DecodeMode::FullValidation,
+                                   bech32::limits::UNLIMITED_LENGTH).dp.size());
+    });
+    bench::run("decode checksum only " + n, bstr.size(), [&] {
+        bench::keep(bech32::decode(bstr, bech32::DecodeMode::ChecksumOnly).dp.size());
+    });
+    bench::run("decode layout only " + n, bstr.size(), [&] {
+        bench::keep(bech32::decode(bstr, bech32::DecodeMode::LayoutOnly).dp.size());
+    });
+
+    // validation only, without producing the hrp and dp
+    bench::run("isValid " + n, bstr.size(), [&] {
+        bench::keep(bech32::isValid(bstr, bech32::limits::UNLIMITED_LENGTH));
+    });
+    bench::run("detectEncoding " + n, bstr.size(), [&] {
+        bench::keep(bech32::detectEncoding(bstr, bech32::limits::UNLIMITED_LENGTH));
+    });
+
+    bench::run("decodePacked " + n, bstr.size(), [&] {
+        bench::keep(bech32::decodePacked(bstr, bech32::limits::UNLIMITED_LENGTH).dp.size());
+    });
+
+    // a view that only reads the first value (e.g., a witness version)
+    bench::run("decodeView first value " + n, bstr.size(), [&] {
+        bech32::DecodedView view = bech32::decodeView(bstr, bech32::limits::UNLIMITED_LENGTH);
+        bench::keep(view.empty() ? 0 : view[0]);
+    });
+
+    // hashing for use as a key, straight from the string or after decoding
+    bench::run("canonicalHash " + n, bstr.size(), [&] {
+        bench::keep(bech32::canonicalHash(bstr, bech32::limits::UNLIMITED_LENGTH));
+    });
+    bench::run("decode then hash " + n, bstr.size(), [&] {
+        bench::keep(std::hash<bech32::DecodedResult>()(bech32::decode(bstr, bech32::limits::UNLIMITED_LENGTH)));
+    });
+
+    // repeated strings served from a cache
+    bech32::DecodeCache cache(1024, 16, bech32::limits::UNLIMITED_LENGTH);
+    bench::run("decode cache hit " + n, bstr.size(), [&] {
+        bench::keep(cache.decode(bstr).dp.size());
+    });
+
+    // a copy of the string with stray spaces, as in text pasted by users
+    std::string dirty;
+    for (size_t i = 0; i < bstr.size(); ++i) {
+        dirty += bstr[i];
+        if (i % 4 == 3)
+            dirty += ' ';
+    }
+    bench::run("decode strip then decode " + n, dirty.size(), [&] {
+        bench::keep(bech32::decode(bech32::stripUnknownChars(dirty),
+                                   bech32::limits::UNLIMITED_LENGTH).dp.size());
+    });
+    bench::run("decode dirty " + n, dirty.size(), [&] {
+        bench::keep(bech32::decodeDirty(dirty, bech32::limits::UNLIMITED_LENGTH).dp.size());
+    });
+
+    // strings for another network are rejected before any checksum work
+    bech32::ExpectedHrps testnet({"tb"});
+    bench::run("decode expected hrp mismatch " + n, bstr.size(), [&] {
+        bench::keep(bech32::decode(bstr, testnet, bech32::limits::UNLIMITED_LENGTH).dp.size());
+    });
+
+    bech32::HrpRegistry registry({"bc", "tb", "bcrt"});
+    bench::run("decode hrp registry " + n, bstr.size(), [&] {
+        bench::keep(bech32::decode(bstr, registry, bech32::limits::UNLIMITED_LENGTH).hrpId);
+    });
+}
+
+int main() {
+    // a segwit v0 address, a taproot address, then longer strings
+    const size_t lengths[] = {32, 52, 250, 1000, 10000};
+
+    for (size_t n : lengths) {
+        runDecodeBenchmarks(bech32::encode<bech32::UnlimitedLength>("bc", randomValues(n)));
+    }
+
+    return 0;
+}
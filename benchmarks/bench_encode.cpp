@@ -0,0 +1,68 @@
+// Benchmarks for encoding into a larger output buffer, as when writing many addresses to a
+// CSV or JSON file, by appending encode()'s result or by encoding in place with encodeTo().
+
+#include "bech32.h"
+#include "bench.h"
+
+#include <random>
+
+namespace {
+
+    std::vector<unsigned char> randomValues(size_t n) {
+        std::mt19937 rng(static_cast<std::mt19937::result_type>(n));
+        std::uniform_int_distribution<int> dist(0, 31);
+        std::vector<unsigned char> ret(n);
+        for (unsigned char &v : ret)
+            v = static_cast<unsigned char>(dist(rng));
+        return ret;
+    }
+
+}
+
+void runEncodeBenchmarks(const std::vector<unsigned char> &dp) {
+    std::string n = std::to_string(dp.size());
+    size_t size = dp.size() + 9;
+    std::string out;
+    out.reserve(1u << 20u);
+
+    bench::run("encode then append " + n, size, [&] {
+        if (out.size() > (1u << 19u))
+            out.clear();
+        out += bech32::encode("bc", dp, bech32::limits::UNLIMITED_LENGTH);
+        out += ',';
+        bench::keep(out.size());
+    });
+    bench::run("encodeTo string " + n, size, [&] {
+        if (out.size() > (1u << 19u))
+            out.clear();
+        bech32::encodeTo(out, "bc", dp, bech32::Encoding::Bech32m, bech32::Lowercase,
+                         bech32::limits::UNLIMITED_LENGTH);
+        out += ',';
+        bench::keep(out.size());
+    });
+    bench::run("encodeTo string uppercase " + n, size, [&] {
+        if (out.size() > (1u << 19u))
+            out.clear();
+        bech32::encodeTo(out, "bc", dp, bech32::Encoding::Bech32m, bech32::Uppercase,
+                         bech32::limits::UNLIMITED_LENGTH);
+        out += ',';
+        bench::keep(out.size());
+    });
+
+    std::vector<char> chars(size);
+    bench::run("encodeTo pointer " + n, size, [&] {
+        bench::keep(bech32::encodeTo(chars.data(), "bc", dp, bech32::Encoding::Bech32m, bech32::Lowercase,
+                                     bech32::limits::UNLIMITED_LENGTH) - chars.data());
+    });
+}
+
+int main() {
+    // a segwit v0 address, a taproot address, then longer strings
+    const size_t lengths[] = {33, 53, 250, 1000, 10000};
+
+    for (size_t n : lengths) {
+        runEncodeBenchmarks(randomValues(n));
+    }
+
+    return 0;
+}
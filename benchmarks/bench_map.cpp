@@ -0,0 +1,58 @@
+// Benchmarks for mapping between data part chars and their 5-bit values, as done for every
+// char of the data part by decode() and encode().
+
+#include "../libbech32/bech32_simd.h"
+#include "bench.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+    std::vector<unsigned char> randomValues(size_t n) {
+        std::mt19937 rng(static_cast<std::mt19937::result_type>(n));
+        std::uniform_int_distribution<int> dist(0, 31);
+        std::vector<unsigned char> ret(n);
+        for (unsigned char &v : ret)
+            v = static_cast<unsigned char>(dist(rng));
+        return ret;
+    }
+
+}
+
+void runMapBenchmarks(const std::vector<unsigned char> &values) {
+    std::string n = std::to_string(values.size());
+    const unsigned char *first = values.data();
+    const unsigned char *last = first + values.size();
+    std::string chars(values.size(), '\0');
+    bech32::simd::mapValuesScalar(first, last, &chars[0]);
+    std::vector<unsigned char> out(values.size());
+
+    bench::run("map chars scalar " + n, values.size(), [&] {
+        bench::keep(bech32::simd::mapCharsScalar(chars.data(), chars.data() + chars.size(), out.data()) - chars.data());
+    });
+    bench::run("map values scalar " + n, values.size(), [&] {
+        bench::keep(bech32::simd::mapValuesScalar(first, last, &chars[0]) - first);
+    });
+#ifdef LIBBECH32_HAVE_SSSE3
+    if (bech32::simd::hasSsse3()) {
+        bench::run("map chars ssse3 " + n, values.size(), [&] {
+            bench::keep(bech32::simd::mapCharsSsse3(chars.data(), chars.data() + chars.size(), out.data()) - chars.data());
+        });
+        bench::run("map values ssse3 " + n, values.size(), [&] {
+            bench::keep(bech32::simd::mapValuesSsse3(first, last, &chars[0]) - first);
+        });
+    }
+#endif
+}
+
+int main() {
+    const size_t lengths[] = {32, 52, 1000, 65536};
+
+    for (size_t n : lengths) {
+        runMapBenchmarks(randomValues(n));
+    }
+
+    return 0;
+}
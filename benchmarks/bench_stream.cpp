@@ -0,0 +1,59 @@
+// Benchmarks for decoding newline-delimited addresses arriving in TCP segment sized chunks:
+// StreamDecoder, compared with collecting the whole stream then splitting and decoding it.
+
+#include "bech32.h"
+#include "bech32_stream.h"
+#include "bench.h"
+
+#include <random>
+#include <sstream>
+
+namespace {
+
+    std::string randomAddressList(size_t n) {
+        std::mt19937 rng(static_cast<std::mt19937::result_type>(n));
+        std::string ret;
+        for (size_t i = 0; i < n; ++i) {
+            std::vector<unsigned char> dp(33);
+            for (unsigned char &v : dp)
+                v = static_cast<unsigned char>(rng() % 32);
+            dp[0] = 0;
+            ret += bech32::encodeUsingOriginalConstant("bc", dp) + '\n';
+        }
+        return ret;
+    }
+
+}
+
+int main() {
+    const size_t counts[] = {1000, 100000};
+    const size_t segmentSize = 1460;
+
+    for (size_t count : counts) {
+        std::string n = std::to_string(count);
+        std::string stream = randomAddressList(count);
+
+        bench::run("StreamDecoder " + n, stream.size(), [&] {
+            size_t valid = 0;
+            bech32::StreamDecoder decoder([&valid](const std::string &, const bech32::DecodedResult &decoded) {
+                valid += decoded.encoding != bech32::Encoding::Invalid;
+            });
+            for (size_t pos = 0; pos < stream.size(); pos += segmentSize)
+                decoder.push(stream.data() + pos, std::min(segmentSize, stream.size() - pos));
+            decoder.finish();
+            bench::keep(valid);
+        });
+        bench::run("collect, getline and decode " + n, stream.size(), [&] {
+            std::string all;
+            for (size_t pos = 0; pos < stream.size(); pos += segmentSize)
+                all.append(stream.data() + pos, std::min(segmentSize, stream.size() - pos));
+            std::istringstream in(all);
+            size_t valid = 0;
+            for (std::string line; std::getline(in, line);)
+                valid += bech32::decode(line).encoding != bech32::Encoding::Invalid;
+            bench::keep(valid);
+        });
+    }
+
+    return 0;
+}
@@ -0,0 +1,62 @@
+// Benchmarks for stripping stray characters from bech32 strings, on inputs from a kilobyte
+// to a megabyte, like large blobs of text pasted by users.
+
+#include "bech32.h"
+#include "../libbech32/bech32_simd.h"
+#include "bench.h"
+
+#include <random>
+
+namespace {
+
+    // text that is mostly bech32 chars, with roughly one stray char in every eight
+    std::string randomText(size_t n) {
+        const std::string charset = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
+        const std::string strays = " -:\n\t,.";
+        std::mt19937 rng(static_cast<std::mt19937::result_type>(n));
+        std::uniform_int_distribution<size_t> pick(0, 7 * charset.size() + strays.size() - 1);
+        std::string ret(n, ' ');
+        for (char &c : ret) {
+            size_t i = pick(rng);
+            c = i < 7 * charset.size() ? charset[i % charset.size()] : strays[i - 7 * charset.size()];
+        }
+        return ret;
+    }
+
+}
+
+void runStripBenchmarks(const std::string &text) {
+    std::string n = std::to_string(text.size());
+    std::string buf(text.size(), '\0');
+
+    bench::run("strip scalar " + n, text.size(), [&] {
+        char *end = bech32::simd::stripUnknownCharsScalar(text.data(), text.data() + text.size(), &buf[0]);
+        bench::keep(end - &buf[0]);
+    });
+#ifdef LIBBECH32_HAVE_SSSE3
+    if (bech32::simd::hasSsse3()) {
+        bench::run("strip ssse3 " + n, text.size(), [&] {
+            char *end = bech32::simd::stripUnknownCharsSsse3(text.data(), text.data() + text.size(), &buf[0]);
+            bench::keep(end - &buf[0]);
+        });
+    }
+#endif
+    bench::run("stripUnknownChars " + n, text.size(), [&] {
+        bench::keep(bech32::stripUnknownChars(text).size());
+    });
+    bench::run("stripUnknownCharsInPlace " + n, text.size(), [&] {
+        buf = text;
+        bech32::stripUnknownCharsInPlace(buf);
+        bench::keep(buf.size());
+    });
+}
+
+int main() {
+    const size_t lengths[] = {1024, 16384, 262144, 1048576};
+
+    for (size_t n : lengths) {
+        runStripBenchmarks(randomText(n));
+    }
+
+    return 0;
+}
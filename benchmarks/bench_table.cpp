@@ -0,0 +1,93 @@
+// Benchmarks for loading a set of addresses and looking addresses up in it: re-decoding a
+// text file of addresses at startup, compared with mapping an address table, and an
+// AddressSet compared with a set of strings.
+
+#include "bech32.h"
+#include "bech32_set.h"
+#include "bech32_table.h"
+#include "bench.h"
+
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <unordered_set>
+
+namespace {
+
+    std::vector<std::string> randomAddresses(size_t n) {
+        std::mt19937 rng(static_cast<std::mt19937::result_type>(n));
+        std::uniform_int_distribution<int> dist(0, 31);
+        std::vector<std::string> ret;
+        for (size_t i = 0; i < n; ++i) {
+            // segwit v0 and taproot sized data parts
+            std::vector<unsigned char> dp(i % 2 ? 33 : 53);
+            for (unsigned char &v : dp)
+                v = static_cast<unsigned char>(dist(rng));
+            ret.push_back(bech32::encode("bc", dp));
+        }
+        return ret;
+    }
+
+}
+
+int main() {
+    const char *path = "bench_address_table.b32";
+    const size_t counts[] = {1000, 100000};
+
+    for (size_t count : counts) {
+        std::string n = std::to_string(count);
+        std::vector<std::string> addresses = randomAddresses(count);
+        std::string text;
+        for (const std::string &address : addresses)
+            text += address + "\n";
+        {
+            std::istringstream in(text);
+            bech32::convertAddressText(in, path);
+        }
+
+        bench::run("load by decoding text " + n, 0, [&] {
+            std::istringstream in(text);
+            std::unordered_set<bech32::DecodedResult> set;
+            std::string line;
+            while (std::getline(in, line))
+                set.insert(bech32::decode(line));
+            bench::keep(set.size());
+        });
+        bench::run("load by mapping table " + n, 0, [&] {
+            bech32::AddressTable table(path);
+            bench::keep(table.size());
+        });
+
+        bech32::AddressTable table(path);
+        size_t i = 0;
+        bench::run("table lookup of string " + n, 0, [&] {
+            bench::keep(table.contains(addresses[i++ % addresses.size()]));
+        });
+        bech32::DecodedResult decoded = bech32::decode(addresses[0]);
+        bench::run("table lookup of decoded " + n, 0, [&] {
+            bench::keep(table.contains(decoded));
+        });
+
+        // addresses that aren't in the set, as for most addresses in a block
+        std::vector<std::string> others = randomAddresses(count + 1);
+        bech32::AddressSet addressSet;
+        std::unordered_set<std::string> stringSet;
+        for (const std::string &address : addresses) {
+            addressSet.insert(address);
+            stringSet.insert(address);
+        }
+        std::printf("AddressSet of %zu holds %zu bytes\n", count, addressSet.memoryUsage());
+        bench::run("AddressSet lookup of string " + n, 0, [&] {
+            bench::keep(addressSet.contains(addresses[i++ % addresses.size()]));
+        });
+        bench::run("AddressSet lookup of other string " + n, 0, [&] {
+            bench::keep(addressSet.contains(others[i++ % others.size()]));
+        });
+        bench::run("unordered_set<string> lookup " + n, 0, [&] {
+            bench::keep(stringSet.count(addresses[i++ % addresses.size()]));
+        });
+    }
+
+    std::remove(path);
+    return 0;
+}
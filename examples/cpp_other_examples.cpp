@@ -41,8 +41,9 @@ void decodeAndEncode() {
     // bech32 string with extra invalid characters
     std::string bstr = " example1:qpz!r--y9#x8&%&%ge-8-sqgv ";
     std::string expected = "example1qpzry9x8ge8sqgv";
-    // decode - make sure to strip invalid characters before trying to decode
-    bech32::DecodedResult decodedResult = bech32::decode(bech32::stripUnknownChars(bstr));
+    // decode - decodeDirty() skips invalid characters, giving the same result as
+    // bech32::decode(bech32::stripUnknownChars(bstr)) without making a cleaned copy
+    bech32::DecodedResult decodedResult = bech32::decodeDirty(bstr);
 
     // verify decoding
     assert(!decodedResult.hrp.empty() && !decodedResult.dp.empty());
@@ -3,9 +3,13 @@
 
 #ifdef __cplusplus
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <iterator>
 
 
 namespace bech32 {
@@ -33,6 +37,9 @@ namespace bech32 {
     // the separator character, which is '1'
     std::string stripUnknownChars(const std::string & bstring);
 
+    // as above, cleaning bstring in place
+    void stripUnknownCharsInPlace(std::string & bstring);
+
     // encode a "human-readable part" and a "data part", returning a bech32m string
     std::string encode(const std::string & hrp, const std::vector<unsigned char> & dp);
 
@@ -68,6 +75,506 @@ namespace bech32 {
         const int MAX_BECH32_LENGTH = 90; // MAX_HRP_LENGTH + '1' + CHECKSUM_LENGTH
 
     }
+
+    // Limits on the length of bech32 strings accepted by decode() and produced by encode().
+    // BIP-0173 limits bech32 strings to 90 characters, but other formats built on bech32
+    // (e.g., BOLT11 lightning invoices, Nostr entities, age keys) use longer strings.
+    struct LengthLimits {
+        std::string::size_type maxHrpLength;
+        std::string::size_type maxBech32Length;
+    };
+
+    // Length policies, for choosing the limits at compile time with decode<>() and encode<>()
+
+    // the limits from BIP-0173: HRP at most 83 chars, whole string at most 90 chars
+    struct StandardLength {
+        static const std::string::size_type maxHrpLength = limits::MAX_HRP_LENGTH;
+        static const std::string::size_type maxBech32Length = limits::MAX_BECH32_LENGTH;
+    };
+
+    // no limits beyond available memory
+    struct UnlimitedLength {
+        static const std::string::size_type maxHrpLength = std::string::npos;
+        static const std::string::size_type maxBech32Length = std::string::npos;
+    };
+
+    namespace limits {
+
+        constexpr LengthLimits STANDARD_LENGTH = {StandardLength::maxHrpLength, StandardLength::maxBech32Length};
+        constexpr LengthLimits UNLIMITED_LENGTH = {UnlimitedLength::maxHrpLength, UnlimitedLength::maxBech32Length};
+
+    }
+
+    // encode a "human-readable part" and a "data part" within the given length limits,
+    // returning a bech32m string
+    std::string encode(const std::string & hrp, const std::vector<unsigned char> & dp,
+                       const LengthLimits & lengthLimits);
+
+    // encode a "human-readable part" and a "data part" within the given length limits,
+    // returning a bech32 string
+    std::string encodeUsingOriginalConstant(const std::string & hrp, const std::vector<unsigned char> & dp,
+                                            const LengthLimits & lengthLimits);
+
+    // decode a bech32 string within the given length limits, returning the "human-readable
+    // part" and a "data part"
+    DecodedResult decode(const std::string & bstring, const LengthLimits & lengthLimits);
+
+    // as above, with the length limits given by a length policy such as UnlimitedLength
+
+    template<typename LengthPolicy>
+    std::string encode(const std::string & hrp, const std::vector<unsigned char> & dp) {
+        return encode(hrp, dp, LengthLimits{LengthPolicy::maxHrpLength, LengthPolicy::maxBech32Length});
+    }
+
+    template<typename LengthPolicy>
+    std::string encodeUsingOriginalConstant(const std::string & hrp, const std::vector<unsigned char> & dp) {
+        return encodeUsingOriginalConstant(
+                hrp, dp, LengthLimits{LengthPolicy::maxHrpLength, LengthPolicy::maxBech32Length});
+    }
+
+    template<typename LengthPolicy>
+    DecodedResult decode(const std::string & bstring) {
+        return decode(bstring, LengthLimits{LengthPolicy::maxHrpLength, LengthPolicy::maxBech32Length});
+    }
+
+    // decode a bech32 string that may contain stray characters not in the allowed charset,
+    // giving the same result as decode(stripUnknownChars(bstring)). The stray characters are
+    // skipped while the HRP and data part are built and checksummed, in a single pass over
+    // bstring and without making a cleaned copy of it
+    DecodedResult decodeDirty(const std::string & bstring,
+                              const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+    // return true if bstring is a valid bech32 string within the length limits, i.e., if
+    // decode() would succeed. Only the checksum is computed: no HRP or data part is
+    // produced, and nothing is allocated
+    bool isValid(const std::string & bstring, const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+    // return the encoding of bstring (Bech32 or Bech32m) if it is a valid bech32 string within
+    // the length limits, otherwise Invalid. As for isValid(), nothing is allocated
+    Encoding detectEncoding(const std::string & bstring, const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+    // A decoded bech32 string that refers to the caller's string instead of copying out the
+    // "human-readable part" and "data part". The checksum is verified when the view is made,
+    // but the data part is only mapped to 5-bit values as it is read, so looking at the HRP or
+    // the first few values (e.g., a witness version) costs no copies. A view is only usable
+    // while the string it was made from is alive and unchanged.
+    class DecodedView {
+    public:
+        // iterates over the values of the data part, mapping each one as it is read
+        class const_iterator {
+        public:
+            typedef std::random_access_iterator_tag iterator_category;
+            typedef unsigned char value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const unsigned char * pointer;
+            typedef unsigned char reference;
+
+            const_iterator() : p(nullptr) {}
+            explicit const_iterator(const char * p) : p(p) {}
+
+            unsigned char operator*() const { return valueOf(*p); }
+            unsigned char operator[](difference_type n) const { return valueOf(p[n]); }
+
+            const_iterator & operator++() { ++p; return *this; }
+            const_iterator operator++(int) { const_iterator ret = *this; ++p; return ret; }
+            const_iterator & operator--() { --p; return *this; }
+            const_iterator operator--(int) { const_iterator ret = *this; --p; return ret; }
+            const_iterator & operator+=(difference_type n) { p += n; return *this; }
+            const_iterator & operator-=(difference_type n) { p -= n; return *this; }
+            const_iterator operator+(difference_type n) const { return const_iterator(p + n); }
+            const_iterator operator-(difference_type n) const { return const_iterator(p - n); }
+            difference_type operator-(const const_iterator & other) const { return p - other.p; }
+
+            bool operator==(const const_iterator & other) const { return p == other.p; }
+            bool operator!=(const const_iterator & other) const { return p != other.p; }
+            bool operator<(const const_iterator & other) const { return p < other.p; }
+            bool operator>(const const_iterator & other) const { return p > other.p; }
+            bool operator<=(const const_iterator & other) const { return p <= other.p; }
+            bool operator>=(const const_iterator & other) const { return p >= other.p; }
+
+        private:
+            const char * p;
+        };
+
+        // an empty view, with encoding Invalid
+        DecodedView() : enc(Invalid), hrpChars(nullptr), hrpSize(0), dataChars(nullptr), dataSize(0) {}
+
+        DecodedView(Encoding encoding, const char * hrp, size_t hrpSize, const char * data, size_t dataSize)
+                : enc(encoding), hrpChars(hrp), hrpSize(hrpSize), dataChars(data), dataSize(dataSize) {}
+
+        Encoding encoding() const { return enc; }
+
+        // the HRP as it appears in the string, which may be upper case
+        const char * hrpData() const { return hrpChars; }
+        size_t hrpLength() const { return hrpSize; }
+
+        // the HRP, lowercased
+        std::string hrp() const;
+
+        // number of values in the data part, not counting the checksum
+        size_t size() const { return dataSize; }
+        bool empty() const { return dataSize == 0; }
+
+        // the value at index i of the data part
+        unsigned char operator[](size_t i) const { return valueOf(dataChars[i]); }
+
+        const_iterator begin() const { return const_iterator(dataChars); }
+        const_iterator end() const { return const_iterator(dataChars + dataSize); }
+
+        // all values of the data part, as in DecodedResult::dp
+        std::vector<unsigned char> dp() const;
+
+        // the value of a data part char, which must be in the charset
+        static unsigned char valueOf(char c);
+
+    private:
+        Encoding enc;
+        const char * hrpChars;
+        size_t hrpSize;
+        const char * dataChars;
+        size_t dataSize;
+    };
+
+    // Decode a bech32 string into a view of it, verifying its checksum. Does not throw or
+    // allocate: if bstring isn't a valid bech32 string within the length limits (i.e., if
+    // decode() would throw or find a bad checksum), an empty view is returned
+    DecodedView decodeView(const std::string & bstring, const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+    DecodedView decodeView(const char * bstring, size_t size, const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+    // a view of a temporary string would be left dangling
+    DecodedView decodeView(std::string && bstring, const LengthLimits & lengthLimits = limits::STANDARD_LENGTH) = delete;
+
+    // The values of a data part (each 0..31) packed at 5 bits each, rather than one per byte
+    // as in DecodedResult::dp, for holding many decoded payloads in memory. Values are packed
+    // most significant bit first, so every 8 values fill 5 bytes.
+    class PackedData {
+    public:
+        PackedData() : count(0) {}
+
+        // pack the given values, which must each be less than 32
+        explicit PackedData(const std::vector<unsigned char> & values);
+
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+
+        // the value at index i
+        unsigned char operator[](size_t i) const {
+            size_t bit = 5 * i;
+            unsigned window = static_cast<unsigned>(bytes[bit / 8]) << 8u | bytes[bit / 8 + 1];
+            return static_cast<unsigned char>(window >> (11 - bit % 8) & 31u);
+        }
+
+        // append a value, which must be less than 32
+        void push_back(unsigned char value);
+
+        // append the values [first, last), which must each be less than 32
+        void append(const unsigned char * first, const unsigned char * last);
+
+        void clear() { bytes.clear(); count = 0; }
+        void reserve(size_t n) { bytes.reserve(packedSize(n)); }
+
+        // write the n values starting at index pos to out
+        void unpack(size_t pos, size_t n, unsigned char * out) const;
+
+        // all the values, as in DecodedResult::dp
+        std::vector<unsigned char> unpack() const;
+
+        // The packed values, followed by a zero byte so that operator[] can always read two
+        // bytes. Unused bits are zero
+        const std::vector<unsigned char> & packedBytes() const { return bytes; }
+
+        bool operator==(const PackedData & other) const { return count == other.count && bytes == other.bytes; }
+        bool operator!=(const PackedData & other) const { return !(*this == other); }
+
+    private:
+        // number of bytes used to hold n values
+        static size_t packedSize(size_t n) { return n == 0 ? 0 : (5 * n + 7) / 8 + 1; }
+
+        // set the bits of the next value, which bytes already has room for
+        void put(unsigned char value);
+
+        std::vector<unsigned char> bytes;
+        size_t count;
+    };
+
+    // Represents the payload within a bech32 string, with the data part packed
+    struct DecodedPackedResult {
+        Encoding encoding;
+        std::string hrp;
+        PackedData dp;
+    };
+
+    // decode a bech32 string as decode() does, packing the data part without an unpacked copy
+    DecodedPackedResult decodePacked(const std::string & bstring, const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+    // Encode a "human-readable part" and a packed "data part", returning a bech32m string.
+    // (These are not overloads of encode(), so that encode(hrp, {}) stays unambiguous.)
+    std::string encodePacked(const std::string & hrp, const PackedData & dp,
+                             const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+    // encode a "human-readable part" and a packed "data part", returning a bech32 string
+    std::string encodePackedUsingOriginalConstant(const std::string & hrp, const PackedData & dp,
+                                                  const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+    // The checksum of a bech32 string computed incrementally, for data parts that are built
+    // up from several sources. A state is seeded with a "human-readable part" and then fed
+    // the values of the data part in any number of chunks, without collecting them into one
+    // vector. States are plain values, so one can be copied (or clone()d) to checksum
+    // several data parts that share a prefix.
+    class ChecksumState {
+    public:
+        // Seed the state with hrp, which is lowercased. Throws if hrp is empty or has a char
+        // value out of range
+        explicit ChecksumState(const std::string & hrp);
+
+        // feed the values in [first, last). Throws, leaving the state unchanged, if any
+        // value is out of range
+        void update(const unsigned char * first, const unsigned char * last);
+        void update(const std::vector<unsigned char> & values) { update(values.data(), values.data() + values.size()); }
+        void update(unsigned char value) { update(&value, &value + 1); }
+
+        // number of values fed so far
+        size_t size() const { return count; }
+
+        ChecksumState clone() const { return *this; }
+
+        // Return the checksum that ends a string of the hrp and the values fed so far:
+        // the bech32m checksum for Bech32m, or the original bech32 one for Bech32. Throws
+        // for Invalid. The state is unchanged, so more values can still be fed
+        std::vector<unsigned char> finalize(Encoding encoding = Encoding::Bech32m) const;
+
+        // as above, writing the 6 checksum values to out
+        void finalize(Encoding encoding, unsigned char * out) const;
+
+        // return the encoding whose checksum the values fed so far end with, or Invalid
+        Encoding verify() const;
+
+    private:
+        uint32_t chk;
+        size_t count;
+    };
+
+    // The case of the letters of an encoded string. Uppercase strings suit QR codes, whose
+    // alphanumeric mode has no lowercase letters
+    enum LetterCase {
+        Lowercase,
+        Uppercase
+    };
+
+    namespace detail {
+
+        // The chars of an encoded string, written a block at a time, for encodeTo(). The
+        // hrp and dp must outlive it
+        class EncodedChars {
+        public:
+            // check that hrp and dp can be encoded within the length limits, and compute the
+            // checksum. Throws as encode() does, or if encoding is Invalid
+            EncodedChars(const std::string & hrp, const std::vector<unsigned char> & dp, Encoding encoding,
+                         LetterCase letterCase, const LengthLimits & lengthLimits);
+
+            // total number of chars
+            size_t size() const { return hrp.size() + 1 + dp.size() + limits::CHECKSUM_LENGTH; }
+
+            // write up to n of the chars not yet written to out, returning how many were
+            size_t read(char * out, size_t n);
+
+        private:
+            const std::string & hrp;
+            const std::vector<unsigned char> & dp;
+            unsigned char checksum[limits::CHECKSUM_LENGTH];
+            LetterCase letterCase;
+            size_t pos;
+        };
+
+    }
+
+    // Encode a "human-readable part" and a "data part" as encode() (for Bech32m) or
+    // encodeUsingOriginalConstant() (for Bech32) does, appending the string to out rather
+    // than returning a new one
+    void encodeTo(std::string & out, const std::string & hrp, const std::vector<unsigned char> & dp,
+                  Encoding encoding = Encoding::Bech32m, LetterCase letterCase = Lowercase,
+                  const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+    // as above, writing the chars of the string to an output iterator, and returning the
+    // iterator past the last char written
+    template<typename OutputIterator>
+    OutputIterator encodeTo(OutputIterator out, const std::string & hrp, const std::vector<unsigned char> & dp,
+                            Encoding encoding = Encoding::Bech32m, LetterCase letterCase = Lowercase,
+                            const LengthLimits & lengthLimits = limits::STANDARD_LENGTH) {
+        detail::EncodedChars chars(hrp, dp, encoding, letterCase, lengthLimits);
+        char block[256];
+        for (size_t n = chars.read(block, sizeof(block)); n != 0; n = chars.read(block, sizeof(block)))
+            out = std::copy(block, block + n, out);
+        return out;
+    }
+
+    // How much checking decode() does. The cheaper modes are meant for strings that have
+    // already been validated, e.g., when they were first stored, and assume bstring is
+    // lowercase (as produced by encode())
+    enum DecodeMode {
+        FullValidation, // all the checks done by decode(bstring)
+        ChecksumOnly,   // verify the checksum, but skip the length, char value and case checks
+        LayoutOnly      // no checks: split at the last separator and map the data chars. The
+                        // checksum is not computed, so the encoding of the result is Invalid
+    };
+
+    // decode a bech32 string with the given amount of checking, returning the
+    // "human-readable part" and a "data part". The length limits only apply to
+    // FullValidation. In the other modes, an empty result is returned if bstring can't be
+    // split into a HRP and a data part at least as long as the checksum
+    DecodedResult decode(const std::string & bstring, DecodeMode mode,
+                         const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+    // A set of expected "human-readable parts", for decoding only the strings that have one
+    // of them. The HRPs are lowercased, and the checksum state of each is computed once, when
+    // the set is built. Throws if any of the HRPs is empty or has a char value out of range.
+    class ExpectedHrps {
+    public:
+        explicit ExpectedHrps(const std::vector<std::string> & hrps);
+
+        // return the index of the HRP equal, ignoring case, to the size chars at hrp, or npos
+        // if there is none
+        size_t find(const char * hrp, size_t size) const;
+
+        // the (lowercase) HRP at index, and the state of the checksum calculation after it
+        const std::string & hrp(size_t index) const { return hrps[index]; }
+        uint32_t checksumState(size_t index) const { return states[index]; }
+
+        static const size_t npos = static_cast<size_t>(-1);
+
+    private:
+        std::vector<std::string> hrps;
+        std::vector<uint32_t> states;
+    };
+
+    // decode a bech32 string only if its "human-readable part" is expectedHrp, ignoring case.
+    // The HRP is compared before any other work is done, and an empty result is returned if
+    // it doesn't match. Otherwise the string is checked and decoded as by decode(bstring).
+    // Throws if expectedHrp is empty
+    DecodedResult decode(const std::string & bstring, const std::string & expectedHrp,
+                         const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+    // as above, accepting any of expectedHrps and reusing their cached checksum states
+    DecodedResult decode(const std::string & bstring, const ExpectedHrps & expectedHrps,
+                         const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+    // Compact id of a HRP in an HrpRegistry
+    typedef uint16_t HrpId;
+
+    // A registry of the "human-readable parts" a service expects, each given a small integer
+    // id in the order they are registered. The HRPs are lowercased and their checksum states
+    // computed once, and a perfect hash table is built for looking them up, so decoding with
+    // a registry does not need to allocate or compare strings to identify the HRP. Throws if
+    // any of the HRPs is empty, has a char value out of range, or is registered twice.
+    class HrpRegistry {
+    public:
+        explicit HrpRegistry(const std::vector<std::string> & hrps);
+
+        // return the id of the HRP equal, ignoring case, to the size chars at hrp, or
+        // unknownHrp if it isn't registered
+        HrpId find(const char * hrp, size_t size) const;
+
+        // the (lowercase) HRP with the given id, and the state of the checksum calculation
+        // after it
+        const std::string & hrp(HrpId id) const { return hrps[id]; }
+        uint32_t checksumState(HrpId id) const { return states[id]; }
+
+        size_t size() const { return hrps.size(); }
+
+        static const HrpId unknownHrp = 0xffff;
+
+    private:
+        std::vector<std::string> hrps;
+        std::vector<uint32_t> states;
+        std::vector<HrpId> slots;
+        uint32_t seed;
+    };
+
+    // Represents the payload within a bech32 string whose HRP was found in an HrpRegistry.
+    // hrpId: the id of the human-readable part, or HrpRegistry::unknownHrp
+    //     dp: the data part
+    struct DecodedIdResult {
+        Encoding encoding;
+        HrpId hrpId;
+        std::vector<unsigned char> dp;
+    };
+
+    // decode a bech32 string whose "human-readable part" is one of those in registry,
+    // returning the id of the HRP and a "data part". The HRP is looked up before any other
+    // work is done, and if it isn't registered the encoding of the result is Invalid and
+    // its hrpId is unknownHrp. Otherwise the string is checked and decoded as by
+    // decode(bstring)
+    DecodedIdResult decode(const std::string & bstring, const HrpRegistry & registry,
+                           const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+    // Re-encode a bech32 string with a new "human-readable part" and encoding (Bech32 or
+    // Bech32m), keeping its data part. The checksum of bstring is verified, then only the HRP
+    // and the checksum chars are rewritten; the data chars are reused as they are, and the
+    // case of the string is kept. Throws if bstring is not a valid bech32 string.
+    std::string transcode(const std::string & bstring, const std::string & newHrp, Encoding newEncoding,
+                          const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+    // as above, rewriting bstring in place
+    void transcodeInPlace(std::string & bstring, const std::string & newHrp, Encoding newEncoding,
+                          const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+    // as above, for each of bstrings. Strings that are not valid bech32 strings are left
+    // unchanged, and their indexes are returned
+    std::vector<size_t> transcodeInPlace(std::vector<std::string> & bstrings, const std::string & newHrp,
+                                         Encoding newEncoding,
+                                         const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+    inline bool operator==(const DecodedResult & a, const DecodedResult & b) {
+        return a.encoding == b.encoding && a.hrp == b.hrp && a.dp == b.dp;
+    }
+
+    inline bool operator!=(const DecodedResult & a, const DecodedResult & b) {
+        return !(a == b);
+    }
+
+    // A 64 bit hash of a payload: its encoding, its HRP (ignoring case) and its data part
+    uint64_t payloadHash(const DecodedResult & decoded);
+
+    // The payloadHash() of decode(bstring), computed straight from the string in one pass
+    // after its checksum is verified, without decoding it. Strings that aren't valid bech32
+    // strings within the length limits get a hash of their chars, ignoring case.
+    uint64_t canonicalHash(const std::string & bstring, const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+    // Hash and equality functors for keying containers by bech32 string, so that strings that
+    // decode to the same payload (e.g., "BC1..." and "bc1...") are the same key. Strings that
+    // aren't valid only equal themselves.
+    struct CanonicalHash {
+        LengthLimits lengthLimits;
+
+        explicit CanonicalHash(const LengthLimits & lengthLimits = limits::STANDARD_LENGTH)
+                : lengthLimits(lengthLimits) {}
+
+        size_t operator()(const std::string & bstring) const {
+            return static_cast<size_t>(canonicalHash(bstring, lengthLimits));
+        }
+    };
+
+    struct CanonicalEqual {
+        LengthLimits lengthLimits;
+
+        explicit CanonicalEqual(const LengthLimits & lengthLimits = limits::STANDARD_LENGTH)
+                : lengthLimits(lengthLimits) {}
+
+        bool operator()(const std::string & a, const std::string & b) const;
+    };
+}
+
+namespace std {
+
+    // consistent with bech32::operator==, and equal to the bech32::canonicalHash() of the
+    // encoded string
+    template<>
+    struct hash<bech32::DecodedResult> {
+        size_t operator()(const bech32::DecodedResult & decoded) const {
+            return static_cast<size_t>(bech32::payloadHash(decoded));
+        }
+    };
+
 }
 
 #endif // #ifdef __cplusplus
@@ -266,6 +773,25 @@ extern bech32_error bech32_decode(
         bech32_DecodedResult *decodedResult,
         const char *str);
 
+/**
+ * check whether a string is a valid bech32 string, without decoding it
+ *
+ * @param str the string to check
+ *
+ * @return 1 if str is a valid bech32 string, 0 if not (or if str is NULL)
+ */
+extern int bech32_is_valid(const char *str);
+
+/**
+ * find the encoding of a bech32 string, without decoding it
+ *
+ * @param str the string to check
+ *
+ * @return ENCODING_BECH32 or ENCODING_BECH32M if str is a valid bech32 string, otherwise
+ * ENCODING_INVALID
+ */
+extern bech32_encoding bech32_detect_encoding(const char *str);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,63 @@
+#ifndef LIBBECH32_BECH32_BASE32_H
+#define LIBBECH32_BECH32_BASE32_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+namespace bech32 {
+
+    // Raw base32 in the bech32 alphabet: binary data written as the charset chars of its
+    // 5-bit groups, most significant bit first, with no HRP, separator or checksum. Every 5
+    // bytes become 8 chars, and a final partial group is padded with zero bits, as the
+    // convertbits() of BIP-0173 does when padding. Groups are regrouped and mapped 16 values
+    // at a time where the CPU allows.
+
+    // return the base32 chars of the size bytes at data
+    std::string encodeBase32(const unsigned char * data, size_t size);
+    std::string encodeBase32(const std::vector<unsigned char> & data);
+
+    // Return the bytes written as base32 chars, in either case. Throws if a char isn't in
+    // the charset, or if the chars don't end on a whole byte followed by zero padding bits
+    std::vector<unsigned char> decodeBase32(const std::string & chars);
+
+    // Encodes binary data that arrives in chunks of any size as base32 chars. Up to 4 bytes
+    // are held back between chunks, until their group of 5 is complete
+    class Base32Encoder {
+    public:
+        Base32Encoder() : pendingSize(0) {}
+
+        // append the chars of the next size bytes to out
+        void update(const unsigned char * data, size_t size, std::string & out);
+
+        // append the chars of the bytes held back, padded, and start over
+        void finish(std::string & out);
+
+    private:
+        unsigned char pending[5];
+        size_t pendingSize;
+    };
+
+    // Decodes base32 chars that arrive in chunks of any size. Up to 7 chars are held back
+    // between chunks, until their group of 8 is complete
+    class Base32Decoder {
+    public:
+        Base32Decoder() : pendingSize(0) {}
+
+        // Append the bytes of the next size chars to out. Throws if a char isn't in the
+        // charset, leaving out and the chars held back as they were
+        void update(const char * chars, size_t size, std::vector<unsigned char> & out);
+
+        // Append the bytes of the chars held back and start over. Throws if the chars didn't
+        // end on a whole byte followed by zero padding bits
+        void finish(std::vector<unsigned char> & out);
+
+    private:
+        unsigned char pending[8];   // values
+        size_t pendingSize;
+    };
+
+}
+
+#endif // LIBBECH32_BECH32_BASE32_H
@@ -0,0 +1,165 @@
+#ifndef LIBBECH32_BECH32_CACHE_H
+#define LIBBECH32_BECH32_CACHE_H
+
+#include "bech32.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace bech32 {
+
+    // Counts from a cache
+    struct CacheStats {
+        uint64_t hits;
+        uint64_t misses;
+        size_t size;    // entries held
+    };
+
+    // A bounded map from keys to computed values that can be used from many threads. Keys
+    // are spread over shards by hash, and each shard is a least-recently-used list behind
+    // its own mutex, so threads only contend when they use the same shard. Values are
+    // computed without holding a lock.
+    template<typename Key, typename Value, typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>>
+    class ShardedLruCache {
+    public:
+        // hold at most (about) capacity entries, in shardCount shards
+        ShardedLruCache(size_t capacity, size_t shardCount)
+                : shardCapacity(std::max<size_t>(1, (capacity + shardCount - 1) / std::max<size_t>(1, shardCount))),
+                  shards(std::max<size_t>(1, shardCount)) {
+            for (std::unique_ptr<Shard> &shard : shards)
+                shard.reset(new Shard());
+        }
+
+        // Return the cached value for key, or compute it with compute(key) and cache it.
+        // If compute throws, nothing is cached.
+        template<typename Compute>
+        Value get(const Key & key, Compute compute) {
+            Shard &shard = shardFor(key);
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                auto it = shard.index.find(&key);
+                if (it != shard.index.end()) {
+                    ++shard.hits;
+                    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+                    return it->second->second;
+                }
+                ++shard.misses;
+            }
+            Value value = compute(key);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            // another thread may have added it meanwhile
+            if (shard.index.find(&key) == shard.index.end()) {
+                shard.entries.emplace_front(key, value);
+                shard.index.emplace(&shard.entries.front().first, shard.entries.begin());
+                if (shard.entries.size() > shardCapacity) {
+                    shard.index.erase(&shard.entries.back().first);
+                    shard.entries.pop_back();
+                }
+            }
+            return value;
+        }
+
+        CacheStats stats() const {
+            CacheStats ret = {0, 0, 0};
+            for (const std::unique_ptr<Shard> &shard : shards) {
+                std::lock_guard<std::mutex> lock(shard->mutex);
+                ret.hits += shard->hits;
+                ret.misses += shard->misses;
+                ret.size += shard->entries.size();
+            }
+            return ret;
+        }
+
+        // drop all entries and reset the counts
+        void clear() {
+            for (std::unique_ptr<Shard> &shard : shards) {
+                std::lock_guard<std::mutex> lock(shard->mutex);
+                shard->index.clear();
+                shard->entries.clear();
+                shard->hits = 0;
+                shard->misses = 0;
+            }
+        }
+
+    private:
+        // the index refers to the keys in the entries, so each key is stored once
+        struct KeyPtrHash {
+            size_t operator()(const Key * key) const { return Hash()(*key); }
+        };
+
+        struct KeyPtrEqual {
+            bool operator()(const Key * a, const Key * b) const { return Equal()(*a, *b); }
+        };
+
+        typedef std::list<std::pair<Key, Value>> Entries;
+
+        struct Shard {
+            Shard() : hits(0), misses(0) {}
+
+            mutable std::mutex mutex;
+            Entries entries;    // most recently used first
+            std::unordered_map<const Key *, typename Entries::iterator, KeyPtrHash, KeyPtrEqual> index;
+            uint64_t hits;
+            uint64_t misses;
+        };
+
+        Shard & shardFor(const Key & key) {
+            // mix the hash, so that shards don't just use its low bits as the maps do
+            uint64_t h = static_cast<uint64_t>(Hash()(key)) * 0x9e3779b97f4a7c15u;
+            return *shards[static_cast<size_t>(h >> 32u) % shards.size()];
+        }
+
+        size_t shardCapacity;
+        std::vector<std::unique_ptr<Shard>> shards;
+    };
+
+    // Caches the results of decode() by input string, including results with a bad
+    // checksum. Strings that decode() throws for aren't cached, and throw each time
+    class DecodeCache {
+    public:
+        explicit DecodeCache(size_t capacity, size_t shardCount = 16,
+                             const LengthLimits & lengthLimits = limits::STANDARD_LENGTH)
+                : lengthLimits(lengthLimits), cache(capacity, shardCount) {}
+
+        // decode bstring as decode(bstring, lengthLimits) does
+        DecodedResult decode(const std::string & bstring);
+
+        CacheStats stats() const { return cache.stats(); }
+        void clear() { cache.clear(); }
+
+    private:
+        LengthLimits lengthLimits;
+        ShardedLruCache<std::string, DecodedResult> cache;
+    };
+
+    // Caches the results of encode() and encodeUsingOriginalConstant() by payload
+    class EncodeCache {
+    public:
+        explicit EncodeCache(size_t capacity, size_t shardCount = 16,
+                             const LengthLimits & lengthLimits = limits::STANDARD_LENGTH)
+                : lengthLimits(lengthLimits), cache(capacity, shardCount) {}
+
+        // encode hrp and dp with the given encoding (Bech32 or Bech32m), as encode() does
+        std::string encode(const std::string & hrp, const std::vector<unsigned char> & dp,
+                           Encoding encoding = Encoding::Bech32m);
+
+        CacheStats stats() const { return cache.stats(); }
+        void clear() { cache.clear(); }
+
+    private:
+        LengthLimits lengthLimits;
+        ShardedLruCache<DecodedResult, std::string> cache;
+    };
+
+}
+
+#endif // LIBBECH32_BECH32_CACHE_H
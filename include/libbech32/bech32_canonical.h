@@ -0,0 +1,109 @@
+#ifndef LIBBECH32_BECH32_CANONICAL_H
+#define LIBBECH32_BECH32_CANONICAL_H
+
+#include "bech32.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace bech32 {
+
+    // Options for canonicalizing and deduplicating bech32 strings
+    struct CanonicalizeOptions {
+        // strings longer than these limits are rejected
+        LengthLimits lengthLimits;
+
+        // If true, data parts whose first value is a segwit witness version (0..16) are
+        // re-encoded with the encoding BIP-0350 requires for it: Bech32 for version 0 and
+        // Bech32m for the others. Otherwise strings keep their encoding.
+        bool segwitEncoding;
+
+        // Bytes of keys held in memory. When the buffered keys reach this size they are
+        // sorted and spilled to a temporary file as a run, and the runs are merged at the
+        // end. Sorting needs a scratch buffer of the same size again. Where long is 32 bits
+        // (as on Windows) this is capped at 1 GiB, so that offsets into a run's file fit
+        // in a long.
+        size_t memoryLimit;
+
+        // number of threads sorting each chunk of keys, or 0 to use the hardware's
+        size_t threads;
+
+        CanonicalizeOptions()
+                : lengthLimits(limits::STANDARD_LENGTH), segwitEncoding(false), memoryLimit(size_t(256) << 20u),
+                  threads(0) {}
+    };
+
+    // Canonicalizes bech32 strings and emits each distinct payload once, as a lowercase
+    // string. Each string's checksum is verified, then its payload is turned into a
+    // fixed-width key: keys are grouped by HRP, encoding and data part length, and within a
+    // group are just the packed data part. Keys are radix sorted a chunk at a time, in
+    // parallel, and merged with any chunks spilled to temporary files, so memory use is
+    // bounded by CanonicalizeOptions::memoryLimit however many strings are added.
+    class AddressDeduplicator {
+    public:
+        explicit AddressDeduplicator(const CanonicalizeOptions & options = CanonicalizeOptions());
+        ~AddressDeduplicator();
+
+        AddressDeduplicator(const AddressDeduplicator &) = delete;
+        AddressDeduplicator & operator=(const AddressDeduplicator &) = delete;
+
+        // add a bech32 string, returning false if it isn't valid within the length limits
+        bool add(const std::string & bstring);
+
+        // Call f with each distinct canonical string, ordered by HRP, encoding, data part
+        // length and then data part, and return how many there were. The deduplicator is
+        // empty afterwards
+        size_t finish(const std::function<void(const std::string &)> & f);
+
+    private:
+        struct Run {
+            std::FILE * file;
+            uint64_t offset;
+            size_t count;
+        };
+
+        struct Group {
+            std::string hrp;
+            Encoding encoding;
+            size_t dataLength;
+            size_t keySize;
+            std::vector<unsigned char> keys;  // buffered, unsorted
+            std::vector<Run> runs;            // spilled, each sorted and unique
+        };
+
+        Group & groupFor(const char * hrp, size_t hrpSize, Encoding encoding, size_t dataLength);
+        void spill();
+        void sortGroup(Group & group);
+
+        CanonicalizeOptions options;
+        std::vector<Group> groups;
+        std::unordered_multimap<uint32_t, size_t> groupIds;   // by hash of HRP, ignoring case, encoding and length
+        std::vector<std::FILE *> files;
+        std::vector<unsigned char> values;
+        std::vector<unsigned char> scratch;
+        size_t buffered;
+        size_t lastGroup;
+    };
+
+    // Counts from canonicalizeAddresses()
+    struct CanonicalizeStats {
+        size_t lines;    // non-blank lines read
+        size_t invalid;  // lines that weren't valid bech32 strings
+        size_t unique;   // distinct canonical strings written
+    };
+
+    // Read newline-delimited bech32 strings from in, and write each distinct canonical
+    // string to out, one per line, as AddressDeduplicator does
+    CanonicalizeStats canonicalizeAddresses(std::istream & in, std::ostream & out,
+                                            const CanonicalizeOptions & options = CanonicalizeOptions());
+
+}
+
+#endif // LIBBECH32_BECH32_CANONICAL_H
@@ -0,0 +1,302 @@
+#ifndef LIBBECH32_BECH32_CHECKSUM_H
+#define LIBBECH32_BECH32_CHECKSUM_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+
+namespace bech32 {
+
+    // The polymod calculation of a BCH code over GF(32), as used for the checksums of
+    // bech32 and related formats such as Liquid's blech32. See BIP-0173 for background.
+    //
+    // State: unsigned integer type that holds the 5 * ChecksumLength bit checksum state
+    // ChecksumLength: number of 5-bit symbols in the checksum
+    // G0..G4: generator coefficients, i.e., the values xored into the state when bit 0..4
+    //         of the symbol shifted out of the top of the state is set
+    //
+    // The calculation is linear over GF(2): running it over a then b gives
+    // shift(polymod(a), b.size()) ^ polymod(b, 0), where shift(chk, n) multiplies chk by x^n
+    // modulo the generator. This lets long inputs be split into chunks that are checksummed
+    // independently, then combined.
+    template<typename State, unsigned ChecksumLength, State G0, State G1, State G2, State G3, State G4>
+    class BchGenerator {
+    public:
+        typedef State state_type;
+
+        static const unsigned checksumLength = ChecksumLength;
+        static const unsigned stateBits = 5 * ChecksumLength;
+
+        // Inputs shorter than this are checksummed by a single chain of folds. Above it, the
+        // input is split into lanes whose folds are interleaved in one loop, so the CPU can
+        // overlap the otherwise serial dependency chains.
+        static const size_t lanes = 4;
+        static const size_t minInterleavedLength = 4096;
+
+        // Inputs at least this long are split across threads by chunked(); shorter ones
+        // are checksummed faster on one thread
+        static const size_t minThreadedLength = size_t(1) << 18u;
+
+        // One step of the polymod calculation: multiply chk by x modulo the generator, then
+        // add value
+        static State step(State chk, unsigned char value) {
+            State top = chk >> (stateBits - 5);
+            return static_cast<State>(
+                    (chk & lowMask) << 5u ^ value ^
+                    ((zero - ((top >> 0) & 1u)) & G0) ^
+                    ((zero - ((top >> 1) & 1u)) & G1) ^
+                    ((zero - ((top >> 2) & 1u)) & G2) ^
+                    ((zero - ((top >> 3) & 1u)) & G3) ^
+                    ((zero - ((top >> 4) & 1u)) & G4));
+        }
+
+        // Run the polymod calculation over [first, last), starting from chk, one symbol at
+        // a time
+        static State serial(const unsigned char *first, const unsigned char *last, State chk) {
+            for (; first != last; ++first)
+                chk = step(chk, *first);
+            return chk;
+        }
+
+        // multiply chk by x^n modulo the generator, i.e., the effect of running the polymod
+        // calculation over n zero values
+        static State shift(State chk, uint64_t n) {
+            const std::vector<ShiftMatrix> &powers = shiftPowers();
+            for (size_t i = 0; n != 0; ++i, n >>= 1u) {
+                if (n & 1u)
+                    chk = applyShift(powers[i], chk);
+            }
+            return chk;
+        }
+
+        // Run the polymod calculation over [first, last), starting from chk, folding
+        // ChecksumLength values per step
+        static State folded(const unsigned char *first, const unsigned char *last, State chk) {
+            const FoldTables &t = foldTables();
+            for (; static_cast<size_t>(last - first) >= ChecksumLength; first += ChecksumLength)
+                chk = fold(t, chk, first);
+            return serial(first, last, chk);
+        }
+
+        // Run the polymod calculation over [first, last), starting from chk, using
+        // interleaved lanes for long inputs
+        static State interleaved(const unsigned char *first, const unsigned char *last, State chk) {
+            auto n = static_cast<size_t>(last - first);
+            if (n < minInterleavedLength)
+                return folded(first, last, chk);
+
+            // each lane is a whole number of folds long. lane 0 starts from chk and also
+            // takes the remainder; the other lanes start from 0
+            size_t k = n / lanes / ChecksumLength * ChecksumLength;
+            const unsigned char *lane1 = last - 3 * k;
+            const unsigned char *lane2 = last - 2 * k;
+            const unsigned char *lane3 = last - k;
+            const unsigned char *lane0 = lane1 - k;
+            State c0 = serial(first, lane0, chk);
+            State c1 = 0, c2 = 0, c3 = 0;
+            const FoldTables &t = foldTables();
+            for (size_t i = 0; i < k; i += ChecksumLength) {
+                c0 = fold(t, c0, lane0 + i);
+                c1 = fold(t, c1, lane1 + i);
+                c2 = fold(t, c2, lane2 + i);
+                c3 = fold(t, c3, lane3 + i);
+            }
+            return shift(shift(shift(c0, k) ^ c1, k) ^ c2, k) ^ c3;
+        }
+
+        // Run the polymod calculation over [first, last), starting from chk, splitting very
+        // long inputs across (at most) the given number of threads. If a thread can't be
+        // started, its chunk is checksummed on the calling thread instead
+        static State chunked(const unsigned char *first, const unsigned char *last, State chk, size_t threads) {
+            auto n = static_cast<size_t>(last - first);
+            if (n < minThreadedLength || threads < 2)
+                return interleaved(first, last, chk);
+
+            threads = std::min(threads, n / (minThreadedLength / 2));
+            size_t k = n / threads;
+            // chunk 0 is handled by this thread and also takes the remainder
+            size_t len0 = n - (threads - 1) * k;
+            std::vector<State> residues(threads - 1);
+            Workers workers;
+            workers.threads.reserve(threads - 1);
+            try {
+                for (size_t t = 0; t < threads - 1; ++t) {
+                    const unsigned char *chunk = first + len0 + t * k;
+                    workers.threads.emplace_back([chunk, k, t, &residues] {
+                        residues[t] = interleaved(chunk, chunk + k, 0);
+                    });
+                }
+            } catch (const std::system_error &) {
+            }
+            chk = interleaved(first, first + len0, chk);
+            for (size_t t = 0; t < threads - 1; ++t) {
+                if (t < workers.threads.size())
+                    workers.threads[t].join();
+                else
+                    residues[t] = interleaved(first + len0 + t * k, first + len0 + (t + 1) * k, 0);
+                chk = shift(chk, k) ^ residues[t];
+            }
+            return chk;
+        }
+
+        // Run the polymod calculation over [first, last), starting from chk, using the
+        // fastest method for the length of the input on the calling thread
+        static State polymod(const unsigned char *first, const unsigned char *last, State chk = 1) {
+            return interleaved(first, last, chk);
+        }
+
+        // Run the polymod calculation over the "expanded" HRP, starting from chk. To expand
+        // the chars of the HRP means to create a new collection of the high bits of each
+        // character's ASCII value, followed by a zero, and then the low bits of each
+        // character. See BIP-0173 for rationale. hrp must already be lowercase.
+        static State expandedHrp(const char *hrp, size_t size, State chk = 1) {
+            for (size_t i = 0; i < size; ++i)
+                chk = step(chk, static_cast<unsigned char>(hrp[i]) >> 5u);
+            chk = step(chk, 0);
+            for (size_t i = 0; i < size; ++i)
+                chk = step(chk, static_cast<unsigned char>(hrp[i]) & 0x1fu);
+            return chk;
+        }
+
+        // polymod of the expanded hrp followed by data
+        static State residue(const std::string &hrp, const std::vector<unsigned char> &data) {
+            State chk = expandedHrp(hrp.data(), hrp.size());
+            return polymod(data.data(), data.data() + data.size(), chk);
+        }
+
+    private:
+        static const State zero = 0;
+        static const State lowMask = (State(1) << (stateBits - 5)) - 1;
+        static const State stateMask = lowMask << 5u | 31u;
+        static const size_t stateBytes = (stateBits + 7) / 8;
+
+        // x^n is linear in chk, so it is represented as a bit matrix whose column j is the
+        // image of bit j
+        typedef std::array<State, stateBits> ShiftMatrix;
+
+        static State applyShift(const ShiftMatrix &m, State chk) {
+            State ret = 0;
+            for (size_t j = 0; chk != 0; ++j, chk >>= 1u) {
+                ret ^= (zero - (chk & 1u)) & m[j];
+            }
+            return ret;
+        }
+
+        // matrices for x^(2^i) modulo the generator, for i = 0..63
+        static const std::vector<ShiftMatrix> & shiftPowers() {
+            static const std::vector<ShiftMatrix> powers = [] {
+                std::vector<ShiftMatrix> ret(64);
+                for (size_t j = 0; j < stateBits; ++j)
+                    ret[0][j] = step(State(1) << j, 0);
+                for (size_t i = 1; i < ret.size(); ++i)
+                    for (size_t j = 0; j < stateBits; ++j)
+                        ret[i][j] = applyShift(ret[i-1], ret[i-1][j]);
+                return ret;
+            }();
+            return powers;
+        }
+
+        // Folding: running the polymod calculation over ChecksumLength values shifts every
+        // bit of chk out of the state, so the result is shift(chk, ChecksumLength) with the
+        // values simply packed into the low bits. shift(chk, ChecksumLength) is linear in chk
+        // and is looked up one byte of chk at a time, the same way table-driven CRCs fold
+        // several input bytes per step.
+        typedef std::array<std::array<State, 256>, stateBytes> FoldTables;
+
+        static const FoldTables & foldTables() {
+            static const FoldTables tables = [] {
+                FoldTables ret;
+                // the bits of the top byte above the state are never set, so they are dropped
+                for (size_t k = 0; k < stateBytes; ++k)
+                    for (size_t b = 0; b < 256; ++b)
+                        ret[k][b] = shift(State(b) << (8 * k) & stateMask, ChecksumLength);
+                return ret;
+            }();
+            return tables;
+        }
+
+        // run the polymod calculation over the ChecksumLength values starting at p
+        static State fold(const FoldTables &t, State chk, const unsigned char *p) {
+            State packed = 0;
+            for (size_t i = 0; i < ChecksumLength; ++i)
+                packed = packed << 5u | p[i];
+            State ret = t[0][chk & 0xffu];
+            for (size_t k = 1; k < stateBytes; ++k)
+                ret ^= t[k][(chk >> (8 * k)) & 0xffu];
+            return ret ^ packed;
+        }
+
+        // the threads of chunked(), which are joined however it returns
+        struct Workers {
+            std::vector<std::thread> threads;
+
+            ~Workers() {
+                for (std::thread &thread : threads) {
+                    if (thread.joinable())
+                        thread.join();
+                }
+            }
+        };
+    };
+
+    // A BCH checksum: the polymod calculation of Generator, with the final state xored with
+    // Constant
+    template<typename Generator, typename Generator::state_type Constant>
+    class BchChecksum {
+    public:
+        typedef typename Generator::state_type state_type;
+        typedef Generator generator_type;
+
+        static const state_type constant = Constant;
+        static const unsigned checksumLength = Generator::checksumLength;
+
+        // return true if the residue of a whole string (hrp, data and checksum) is valid
+        static bool verifyResidue(state_type residue) {
+            return residue == Constant;
+        }
+
+        // verify the checksum at the end of dp. hrp must already be lowercase
+        static bool verify(const std::string &hrp, const std::vector<unsigned char> &dp) {
+            return verifyResidue(Generator::residue(hrp, dp));
+        }
+
+        // Write the checksum for a string whose hrp and data have been run through the
+        // polymod calculation, giving chk
+        template<typename OutputIterator>
+        static OutputIterator create(state_type chk, OutputIterator out) {
+            for (unsigned i = 0; i < checksumLength; ++i)
+                chk = Generator::step(chk, 0);
+            chk ^= Constant;
+            for (unsigned i = 0; i < checksumLength; ++i)
+                *out++ = static_cast<unsigned char>((chk >> (5 * (checksumLength - 1 - i))) & 31u);
+            return out;
+        }
+
+        // return the checksum for hrp and dp. hrp must already be lowercase
+        static std::vector<unsigned char> create(const std::string &hrp, const std::vector<unsigned char> &dp) {
+            std::vector<unsigned char> ret(checksumLength);
+            create(Generator::residue(hrp, dp), ret.begin());
+            return ret;
+        }
+    };
+
+    // The BCH code used by bech32 and bech32m (BIP-0173, BIP-0350)
+    typedef BchGenerator<uint32_t, 6,
+            0x3b6a57b2, 0x26508e6d, 0x1ea119fa, 0x3d4233dd, 0x2a1462b3> Bech32Generator;
+    typedef BchChecksum<Bech32Generator, 1> Bech32Checksum;
+    typedef BchChecksum<Bech32Generator, 0x2bc830a3> Bech32mChecksum;
+
+    // The BCH code used by Liquid's blech32 and blech32m, with a 12 symbol checksum
+    typedef BchGenerator<uint64_t, 12,
+            0x7d52fba40bd886, 0x5e8dbf1a03950c, 0x1c3a3c74072a18, 0x385d72fa0e5139, 0x7093e5a608865b> Blech32Generator;
+    typedef BchChecksum<Blech32Generator, 1> Blech32Checksum;
+    typedef BchChecksum<Blech32Generator, 0x455972a3350f7a1> Blech32mChecksum;
+
+}
+
+#endif // LIBBECH32_BECH32_CHECKSUM_H
@@ -0,0 +1,60 @@
+#ifndef LIBBECH32_BECH32_COLUMNAR_H
+#define LIBBECH32_BECH32_COLUMNAR_H
+
+#include "bech32.h"
+
+#include <cstdint>
+
+
+namespace bech32 {
+
+    // A column of strings in the layout of Arrow's string and binary arrays: string i is the
+    // bytes [offsets[i], offsets[i + 1]) of data, so offsets has size + 1 entries. The
+    // column refers to the caller's buffers, which it doesn't copy.
+    struct StringColumn {
+        const int32_t * offsets;
+        const char * data;
+        size_t size;
+    };
+
+    // Buffers that decodeColumn() writes a column of results to, one entry per string,
+    // which are also laid out as Arrow arrays. The caller allocates them, and any except
+    // validity may be nullptr to skip that column:
+    //
+    //     validity     bitmap of the valid strings, least significant bit first:
+    //                  (size + 7) / 8 bytes. Bits past the last string are cleared
+    //     encodings    Encoding of each string, Invalid for invalid strings: size bytes
+    //     hrpIds       id of each string's HRP in the registry, or HrpRegistry::unknownHrp
+    //                  for invalid strings: size entries
+    //     dataLengths  number of data part values of each string, or 0 for invalid ones:
+    //                  size entries
+    //     dataOffsets  offsets of each string's packed data part in data, as for a binary
+    //                  array: size + 1 entries, starting at 0. Invalid strings are empty
+    //     data         the data parts, each packed at 5 bits per value as in PackedData.
+    //                  Needs at most as many bytes as the strings have in total. Written
+    //                  only with dataOffsets
+    struct DecodedColumns {
+        uint8_t * validity;
+        uint8_t * encodings;
+        HrpId * hrpIds;
+        int32_t * dataLengths;
+        int32_t * dataOffsets;
+        unsigned char * data;
+    };
+
+    // Decode each string of column, as decode(bstring, registry, lengthLimits) would, into
+    // the output columns, and return the number of valid strings. A string is valid if it is
+    // a valid bech32 string within the length limits whose HRP is in registry. Nothing is
+    // allocated per string. Throws if the offsets decrease
+    size_t decodeColumn(const StringColumn & column, const HrpRegistry & registry, const DecodedColumns & out,
+                        const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+    // Check each string of column, writing the validity bitmap and, unless it is nullptr,
+    // the encoding of each string, and return the number of valid strings. Any HRP is
+    // allowed. Throws if the offsets decrease
+    size_t validateColumn(const StringColumn & column, uint8_t * validity, uint8_t * encodings,
+                          const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+}
+
+#endif // LIBBECH32_BECH32_COLUMNAR_H
@@ -0,0 +1,90 @@
+#ifndef LIBBECH32_BECH32_RANGES_H
+#define LIBBECH32_BECH32_RANGES_H
+
+// Range adaptors for decoding sequences of bech32 strings lazily. They need C++20 ranges,
+// and this header is empty without them.
+
+#include "bech32.h"
+
+// check the library's feature macro rather than __cplusplus, which MSVC only sets to the
+// standard in use when built with /Zc:__cplusplus
+#if defined(__has_include)
+#if __has_include(<version>)
+#include <version>
+#endif
+#endif
+
+#ifdef __cpp_lib_ranges
+#include <ranges>
+#endif
+
+#ifdef __cpp_lib_ranges
+
+#include <string>
+#include <string_view>
+
+
+namespace bech32 {
+
+    namespace views {
+
+        // Maps a string to its decodeView(). Strings that are temporaries (e.g., made by an
+        // earlier transform) are rejected at compile time, as the views would dangle
+        struct DecodeString {
+            LengthLimits lengthLimits;
+
+            DecodedView operator()(const std::string & bstring) const {
+                return decodeView(bstring, lengthLimits);
+            }
+
+            DecodedView operator()(std::string_view bstring) const {
+                return decodeView(bstring.data(), bstring.size(), lengthLimits);
+            }
+
+            // C strings would otherwise convert equally well to both of the above
+            DecodedView operator()(const char * bstring) const {
+                return (*this)(std::string_view(bstring));
+            }
+
+            DecodedView operator()(std::string && bstring) const = delete;
+        };
+
+        // Decode each string of a range into a DecodedView as the range is iterated:
+        //
+        //     for (bech32::DecodedView view : lines | bech32::views::decode | bech32::views::valid)
+        //
+        // Views refer to the strings of the range, and nothing is allocated per string. As
+        // with decodeView(), an invalid string gives an empty view whose encoding is Invalid
+        inline constexpr auto decode = std::views::transform(DecodeString{limits::STANDARD_LENGTH});
+
+        // as above, within the given length limits
+        inline auto decodeWithin(const LengthLimits & lengthLimits) {
+            return std::views::transform(DecodeString{lengthLimits});
+        }
+
+        // true for views of strings with the given encoding
+        struct HasEncoding {
+            Encoding encoding;
+
+            bool operator()(const DecodedView & view) const {
+                return view.encoding() == encoding;
+            }
+        };
+
+        // keep only the views of valid strings
+        inline constexpr auto valid = std::views::filter([](const DecodedView & view) {
+            return view.encoding() != Encoding::Invalid;
+        });
+
+        // keep only the views of strings with the given encoding, e.g., Bech32m
+        inline auto withEncoding(Encoding encoding) {
+            return std::views::filter(HasEncoding{encoding});
+        }
+
+    }
+
+}
+
+#endif // __cpp_lib_ranges
+
+#endif // LIBBECH32_BECH32_RANGES_H
@@ -0,0 +1,81 @@
+#ifndef LIBBECH32_BECH32_SET_H
+#define LIBBECH32_BECH32_SET_H
+
+#include "bech32.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace bech32 {
+
+    // A set of decoded payloads, for checking many addresses against a large watch list.
+    //
+    // Payloads are grouped by HRP, encoding and data part length, and each group is an open
+    // addressing hash table whose slots are the packed data part (5 bits per value, as in
+    // PackedData) plus a one byte tag from the hash, which marks the slot as used and rules
+    // out most slots without comparing keys. Nothing else is stored per payload, so a 33
+    // value segwit v0 payload takes 22 bytes per slot. Tables grow by half when they are 4/5
+    // full.
+    //
+    // Strings of standard length are looked up without allocating: their checksum is
+    // verified and their data part packed straight from the string.
+    class AddressSet {
+    public:
+        AddressSet() : count(0) {}
+
+        // Add a payload, returning true if it wasn't already in the set. Throws if its
+        // encoding is Invalid or any of its data values is out of range
+        bool insert(const DecodedResult & decoded);
+
+        // decode a bech32 string and add its payload, returning true if the string is valid
+        // within the length limits and its payload wasn't already in the set
+        bool insert(const std::string & bstring, const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+        // return true if the set holds the payload
+        bool contains(const DecodedResult & decoded) const;
+
+        // return true if bstring is a valid bech32 string within the length limits and the
+        // set holds its payload
+        bool contains(const std::string & bstring, const LengthLimits & lengthLimits = limits::STANDARD_LENGTH) const;
+
+        // number of payloads in the set
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+
+        // number of bytes held by the set's tables
+        size_t memoryUsage() const;
+
+    private:
+        struct Group {
+            HrpId hrpId;
+            Encoding encoding;
+            size_t dataLength;
+            size_t keySize;
+            size_t used;
+            std::vector<uint8_t> tags;      // 0 for an empty slot
+            std::vector<unsigned char> keys;
+        };
+
+        HrpId findHrp(const char * hrp, size_t size) const;
+        static uint64_t groupKey(HrpId hrpId, Encoding encoding, size_t dataLength);
+        size_t groupIndex(HrpId hrpId, Encoding encoding, size_t dataLength) const;
+        const Group * findGroup(HrpId hrpId, Encoding encoding, size_t dataLength) const;
+        Group & groupFor(const std::string & hrp, Encoding encoding, size_t dataLength);
+
+        static bool groupContains(const Group & group, const unsigned char * key);
+        static bool groupInsert(Group & group, const unsigned char * key);
+        static void grow(Group & group);
+
+        std::vector<std::string> hrps;                      // lowercase, by id
+        std::unordered_multimap<uint32_t, HrpId> hrpIds;    // by hash of the HRP, ignoring case
+        std::vector<Group> groups;
+        std::unordered_map<uint64_t, size_t> groupIds;      // by groupKey()
+        size_t count;
+    };
+
+}
+
+#endif // LIBBECH32_BECH32_SET_H
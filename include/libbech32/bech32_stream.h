@@ -0,0 +1,69 @@
+#ifndef LIBBECH32_BECH32_STREAM_H
+#define LIBBECH32_BECH32_STREAM_H
+
+#include "bech32.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+namespace bech32 {
+
+    // Decodes bech32 strings separated by delimiter chars from a stream that arrives in
+    // chunks of any size, such as network reads, where a string may be split across chunks.
+    // Each string is reported as soon as the delimiter after it (or the end of the stream)
+    // is pushed.
+    //
+    // Only the string in progress is held, and never more than the length limits allow. The
+    // separator of a string is its last '1', and no data part char can be a '1', so the data
+    // chars after the latest '1' are mapped and run through the checksum calculation as they
+    // arrive. That calculation starts from zero rather than from the HRP's state; since it is
+    // linear, the HRP's state is shifted past the data and added in when the string ends.
+    class StreamDecoder {
+    public:
+        // Called with each string and its decode() result. The encoding of the result is
+        // Invalid if the string isn't a valid bech32 string within the length limits (where
+        // decode() would throw or find a bad checksum). A string longer than the limits is
+        // passed cut short at the maximum length
+        typedef std::function<void(const std::string & bstring, const DecodedResult & decoded)> Callback;
+
+        explicit StreamDecoder(const Callback & callback,
+                               const LengthLimits & lengthLimits = limits::STANDARD_LENGTH,
+                               const std::string & delimiters = " \t\r\n,");
+
+        // decode the strings completed by the next size chars of the stream
+        void push(const char * chunk, size_t size);
+        void push(const std::string & chunk) { push(chunk.data(), chunk.size()); }
+
+        // end the stream, completing the last string if no delimiter followed it. The
+        // decoder can then be used for a new stream
+        void finish();
+
+        // number of strings reported so far
+        size_t count() const { return completed; }
+
+    private:
+        void append(const char * first, const char * last);
+        void complete();
+        DecodedResult decodeToken() const;
+
+        Callback callback;
+        LengthLimits lengthLimits;
+        bool isDelimiter[256];
+
+        // the string in progress
+        std::string token;
+        size_t separatorPos;                // of the latest '1', or npos
+        std::vector<unsigned char> values;  // of the data chars after it
+        uint32_t dataChk;                   // polymod of values, starting from 0
+        bool badData;                       // a char after the separator isn't in the charset
+        bool tooLong;
+
+        size_t completed;
+    };
+
+}
+
+#endif // LIBBECH32_BECH32_STREAM_H
@@ -0,0 +1,129 @@
+#ifndef LIBBECH32_BECH32_TABLE_H
+#define LIBBECH32_BECH32_TABLE_H
+
+#include "bech32.h"
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+
+namespace bech32 {
+
+    // Address tables: files of decoded bech32 payloads that are opened by mapping them into
+    // memory, so that a large set of addresses can be searched without parsing anything
+    // at startup.
+    //
+    // All integers are big-endian. The file starts with a 40 byte header:
+    //
+    //     magic         8 bytes  "B32TABLE"
+    //     version       u32      1
+    //     hrpCount      u32      number of HRPs
+    //     maxDataLength u32      most data part values in a record
+    //     recordSize    u32      5 + ceil(5 * maxDataLength / 8)
+    //     recordCount   u64      number of records
+    //     recordsOffset u64      offset of the first record
+    //
+    // which is followed by the HRPs (each a u16 length and the lowercase chars), whose
+    // index is their id. The records start at recordsOffset, and each is:
+    //
+    //     hrpId         u16
+    //     encoding      u8       Bech32 or Bech32m
+    //     dataLength    u16      number of data part values
+    //     data          packed 5 bits per value, as in PackedData, padded with zeros
+    //
+    // Records are fixed width, unique and sorted by their bytes, so the records are their
+    // own index: a lookup is a binary search.
+    class AddressTableWriter {
+    public:
+        // add a decoded payload. Throws if its encoding is Invalid or it can't be stored
+        void add(const DecodedResult & decoded);
+        void add(const DecodedPackedResult & decoded);
+
+        // decode a bech32 string and add it, returning false if it isn't a valid bech32
+        // string within the length limits
+        bool add(const std::string & bstring, const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+        // number of payloads added, including duplicates
+        size_t size() const { return entries.size(); }
+
+        // write the table to the file at path, replacing it. Throws if it can't be written
+        void write(const std::string & path) const;
+
+    private:
+        struct Entry {
+            uint64_t offset;   // of the packed data in packed
+            uint16_t hrpId;
+            uint8_t encoding;
+            uint16_t dataLength;
+        };
+
+        HrpId hrpIdOf(const std::string & hrp);
+
+        std::vector<std::string> hrps;
+        std::vector<Entry> entries;
+        std::vector<unsigned char> packed;
+    };
+
+    // Convert newline-delimited bech32 strings read from in to an address table at path.
+    // Blank lines are skipped, as are lines that aren't valid bech32 strings within the
+    // length limits; the (1-based) numbers of those lines are returned
+    std::vector<size_t> convertAddressText(std::istream & in, const std::string & path,
+                                           const LengthLimits & lengthLimits = limits::STANDARD_LENGTH);
+
+    // A read-only address table, mapped into memory
+    class AddressTable {
+    public:
+        // map the address table at path. Throws if it can't be opened or isn't a valid
+        // address table
+        explicit AddressTable(const std::string & path);
+        ~AddressTable();
+
+        AddressTable(const AddressTable &) = delete;
+        AddressTable & operator=(const AddressTable &) = delete;
+
+        // number of records
+        size_t size() const { return recordCount; }
+
+        // the HRPs in the table, indexed by id
+        const std::vector<std::string> & hrps() const { return hrpList; }
+
+        // the payload of the record at index i
+        DecodedResult operator[](size_t i) const;
+
+        // return the index of the record for a decoded payload, or npos if there is none
+        size_t find(const DecodedResult & decoded) const;
+
+        // return the index of the record for the payload of a bech32 string, or npos if
+        // there is none or bstring isn't a valid bech32 string within the length limits
+        size_t find(const std::string & bstring, const LengthLimits & lengthLimits = limits::STANDARD_LENGTH) const;
+
+        bool contains(const DecodedResult & decoded) const { return find(decoded) != npos; }
+        bool contains(const std::string & bstring, const LengthLimits & lengthLimits = limits::STANDARD_LENGTH) const {
+            return find(bstring, lengthLimits) != npos;
+        }
+
+        static const size_t npos = static_cast<size_t>(-1);
+
+    private:
+        // binary search for a record equal to key, which is recordSize bytes
+        size_t findRecord(const unsigned char * key) const;
+
+        // make the key of a payload, returning false if it can't be in the table
+        bool makeKey(HrpId hrpId, Encoding encoding, const std::vector<unsigned char> & dp,
+                     std::vector<unsigned char> & key) const;
+
+        const unsigned char * base;
+        size_t mappedSize;
+        size_t recordCount;
+        size_t recordSize;
+        size_t maxDataLength;
+        const unsigned char * records;
+        std::vector<std::string> hrpList;
+        HrpRegistry registry;
+    };
+
+}
+
+#endif // LIBBECH32_BECH32_TABLE_H
@@ -1,40 +1,20 @@
 #include "bech32.h"
+#include "bech32_caseless.h"
+#include "bech32_charset.h"
+#include "bech32_checksum.h"
+#include "bech32_simd.h"
 #include <algorithm>
+#include <cstring>
 #include <stdexcept>
 
 namespace {
 
     using namespace bech32::limits;
 
-    // constant used in checksum generation. see:
-    // https://github.com/bitcoin/bips/blob/master/bip-0173.mediawiki
-    // https://github.com/bitcoin/bips/blob/master/bip-0350.mediawiki
-    const unsigned int M = 0x2bc830a3;
-
-    /** The Bech32 character set for encoding. The index into this array gives the char
-     * each value is mapped to, i.e., 0 -> 'q', 10 -> '2', etc. This comes from the table
-     * in BIP-0173 */
-    const char charset[VALID_CHARSET_SIZE] = {
-            'q', 'p', 'z', 'r', 'y', '9', 'x', '8', 'g', 'f', '2', 't', 'v', 'd', 'w', '0', // indexes 0 - F
-            's', '3', 'j', 'n', '5', '4', 'k', 'h', 'c', 'e', '6', 'm', 'u', 'a', '7', 'l'  // indexes 10 - 1F
-    };
-
-    /** The Bech32 character set for decoding. This comes from the table in BIP-0173
-     *
-     * This will help map both upper and lowercase chars into the proper code (or index
-     * into the above charset). For instance, 'Q' (ascii 81) and 'q' (ascii 113)
-     * are both set to index 0 in this table. Invalid chars are set to -1 */
-    const int REVERSE_CHARSET_SIZE = 128;
-    const int8_t reverse_charset[REVERSE_CHARSET_SIZE] = {
-            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-            15, -1, 10, 17, 21, 20, 26, 30,  7,  5, -1, -1, -1, -1, -1, -1,
-            -1, 29, -1, 24, 13, 25,  9,  8, 23, -1, 18, 22, 31, 27, 19, -1,
-            1,  0,  3, 16, 11, 28, 12, 14,  6,  4,  2, -1, -1, -1, -1, -1,
-            -1, 29, -1, 24, 13, 25,  9,  8, 23, -1, 18, 22, 31, 27, 19, -1,
-            1,  0,  3, 16, 11, 28, 12, 14,  6,  4,  2, -1, -1, -1, -1, -1
-    };
+    // the charset tables, shared with the SIMD kernels
+    using bech32::tables::charset;
+    using bech32::tables::reverse_charset;
+    using bech32::tables::REVERSE_CHARSET_SIZE;
 
     // bech32 string can not mix upper and lower case
     void rejectBStringMixedCase(const std::string &bstring) {
@@ -53,9 +33,10 @@ namespace {
         }
     }
 
-    // bech32 string can be at most 90 characters long
-    void rejectBStringTooLong(const std::string &bstring) {
-        if (bstring.size() > MAX_BECH32_LENGTH)
+    // bech32 string can be at most 90 characters long, unless other limits are given
+    void rejectBStringTooLong(const std::string &bstring,
+                              std::string::size_type maxLength = MAX_BECH32_LENGTH) {
+        if (bstring.size() > maxLength)
             throw std::runtime_error("bech32 string too long");
     }
 
@@ -73,9 +54,10 @@ namespace {
     }
 
     // bech32 string must conform to rules laid out in BIP-0173
-    void rejectBStringThatIsntWellFormed(const std::string &bstring) {
+    void rejectBStringThatIsntWellFormed(const std::string &bstring,
+                                         const bech32::LengthLimits &lengthLimits = STANDARD_LENGTH) {
         rejectBStringTooShort(bstring);
-        rejectBStringTooLong(bstring);
+        rejectBStringTooLong(bstring, lengthLimits.maxBech32Length);
         rejectBStringMixedCase(bstring);
         rejectBStringValuesOutOfRange(bstring);
         rejectBStringWithNoSeparator(bstring);
@@ -108,44 +90,35 @@ namespace {
         std::transform(str.begin(), str.end(), str.begin(), &::tolower);
     }
 
-    // dp needs to be mapped using the reverse_charset table
+    // map a data part char to its value using the reverse_charset table
+    inline unsigned char mapChar(char ch) {
+        auto c = static_cast<unsigned char>(ch);
+        if(c > REVERSE_CHARSET_SIZE - 1)
+            throw std::runtime_error("data part contains character value out of range");
+        int8_t d = reverse_charset[c];
+        if(d == -1)
+            throw std::runtime_error("data part contains invalid character");
+        return static_cast<unsigned char>(d);
+    }
+
+    // dp needs to be mapped using the reverse_charset table. The mapping kernel stops at the
+    // first char that isn't in the charset, which mapChar() then throws for
     void mapDP(std::vector<unsigned char> &dp) {
-        for(unsigned char &c : dp) {
-            if(c > REVERSE_CHARSET_SIZE - 1)
-                throw std::runtime_error("data part contains character value out of range");
-            int8_t d = reverse_charset[c];
-            if(d == -1)
-                throw std::runtime_error("data part contains invalid character");
-            c = static_cast<unsigned char>(d);
-        }
+        const char *first = reinterpret_cast<const char *>(dp.data());
+        const char *last = first + dp.size();
+        const char *bad = bech32::simd::mapChars(first, last, dp.data());
+        if (bad != last)
+            mapChar(*bad);
     }
 
     // using the charset of valid chars, map the incoming data
     std::string mapToCharset(std::vector<unsigned char> &data) {
-        std::string ret;
-        ret.reserve(data.size());
-        for (unsigned char c : data) {
-            if(c > VALID_CHARSET_SIZE - 1)
-                throw std::runtime_error("data part contains invalid character");
-            ret += charset[c];
-        }
-        return ret;
-    }
-
-    // "expand" the HRP -- adapted from example in BIP-0173
-    //
-    // To expand the chars of the HRP means to create a new collection of
-    // the high bits of each character's ASCII value, followed by a zero,
-    // and then the low bits of each character. See BIP-0173 for rationale.
-    std::vector<unsigned char> expandHrp(const std::string & hrp) {
-        std::string::size_type sz = hrp.size();
-        std::vector<unsigned char> ret(sz * 2 + 1);
-        for(std::string::size_type i=0; i < sz; ++i) {
-            auto c = static_cast<unsigned char>(hrp[i]);
-            ret[i] = c >> 5u;
-            ret[i + sz + 1] = c & static_cast<unsigned char>(0x1f);
-        }
-        ret[sz] = 0;
+        std::string ret(data.size(), '\0');
+        if (data.empty())
+            return ret;
+        const unsigned char *last = data.data() + data.size();
+        if (bech32::simd::mapValues(data.data(), last, &ret[0]) != last)
+            throw std::runtime_error("data part contains invalid character");
         return ret;
     }
 
@@ -156,57 +129,18 @@ namespace {
         return ret;
     }
 
-    // Find the polynomial with value coefficients mod the generator as 30-bit.
-    // Adapted from Pieter Wuille's code in BIP-0173
-    uint32_t polymod(const std::vector<unsigned char> &values) {
-        uint32_t chk = 1;
-        for (unsigned char value : values) {
-            auto top = static_cast<uint8_t>(chk >> 25u);
-            chk = static_cast<uint32_t>(
-                    (chk & 0x1ffffffu) << 5u ^ value ^
-                    (-((top >> 0) & 1u) & 0x3b6a57b2UL) ^
-                    (-((top >> 1) & 1u) & 0x26508e6dUL) ^
-                    (-((top >> 2) & 1u) & 0x1ea119faUL) ^
-                    (-((top >> 3) & 1u) & 0x3d4233ddUL) ^
-                    (-((top >> 4) & 1u) & 0x2a1462b3UL));
-        }
-        return chk;
-    }
-
-    bool verifyChecksum(const std::string &hrp, const std::vector<unsigned char> &dp) {
-        return polymod(cat(expandHrp(hrp), dp)) == M;
-    }
-
-    bool verifyChecksumUsingOriginalConstant(const std::string &hrp, const std::vector<unsigned char> &dp) {
-        return polymod(cat(expandHrp(hrp), dp)) == 1;
-    }
-
     void stripChecksum(std::vector<unsigned char> &dp) {
         dp.erase(dp.end() - CHECKSUM_LENGTH, dp.end());
     }
 
     std::vector<unsigned char>
     createChecksum(const std::string &hrp, const std::vector<unsigned char> &dp) {
-        std::vector<unsigned char> c = cat(expandHrp(hrp), dp);
-        c.resize(c.size() + CHECKSUM_LENGTH);
-        uint32_t mod = polymod(c) ^ M;
-        std::vector<unsigned char> ret(CHECKSUM_LENGTH);
-        for(std::vector<unsigned char>::size_type i = 0; i < CHECKSUM_LENGTH; ++i) {
-            ret[i] = static_cast<unsigned char>((mod >> (5 * (5 - i))) & 31u);
-        }
-        return ret;
+        return bech32::Bech32mChecksum::create(hrp, dp);
     }
 
     std::vector<unsigned char>
     createChecksumUsingOriginalConstant(const std::string &hrp, const std::vector<unsigned char> &dp) {
-        std::vector<unsigned char> c = cat(expandHrp(hrp), dp);
-        c.resize(c.size() + CHECKSUM_LENGTH);
-        uint32_t mod = polymod(c) ^ 1;
-        std::vector<unsigned char> ret(CHECKSUM_LENGTH);
-        for(std::vector<unsigned char>::size_type i = 0; i < CHECKSUM_LENGTH; ++i) {
-            ret[i] = static_cast<unsigned char>((mod >> (5 * (5 - i))) & 31u);
-        }
-        return ret;
+        return bech32::Bech32Checksum::create(hrp, dp);
     }
 
     void rejectHRPTooShort(const std::string &hrp) {
@@ -214,9 +148,9 @@ namespace {
             throw std::runtime_error("HRP must be at least one character");
     }
 
-    void rejectHRPTooLong(const std::string &hrp) {
-        if(hrp.size() > MAX_HRP_LENGTH)
-            throw std::runtime_error("HRP must be less than 84 characters");
+    void rejectHRPTooLong(const std::string &hrp, std::string::size_type maxHrpLength = MAX_HRP_LENGTH) {
+        if(hrp.size() > maxHrpLength)
+            throw std::runtime_error("HRP must be less than " + std::to_string(maxHrpLength + 1) + " characters");
     }
 
     void rejectDPTooShort(const std::vector<unsigned char> &dp) {
@@ -232,17 +166,347 @@ namespace {
     }
 
     // length of human part plus length of data part plus separator char plus 6 char
-    // checksum must be less than 90
-    void rejectBothPartsTooLong(const std::string &hrp, const std::vector<unsigned char> &dp) {
-        if(hrp.length() + dp.size() + 1 + CHECKSUM_LENGTH > MAX_BECH32_LENGTH) {
+    // checksum must be less than 90, unless other limits are given
+    void rejectBothPartsTooLong(const std::string &hrp, std::string::size_type dpSize,
+                                std::string::size_type maxLength = MAX_BECH32_LENGTH) {
+        if(hrp.length() + dpSize + 1 + CHECKSUM_LENGTH > maxLength) {
+            throw std::runtime_error("length of hrp + length of dp is too large");
+        }
+    }
+
+    void rejectBothPartsTooLong(const std::string &hrp, const std::vector<unsigned char> &dp,
+                                std::string::size_type maxLength = MAX_BECH32_LENGTH) {
+        rejectBothPartsTooLong(hrp, dp.size(), maxLength);
+    }
+
+    // Run the polymod calculation over the data part chars [first, last), continuing from
+    // chk. Chars are mapped a block at a time so the folded polymod kernels can be used
+    // without mapping the whole data part into a separate buffer. Returns a pointer to the
+    // first char that isn't in the charset, or last if all of them are
+    const char *continuePolymodOverDataChars(const char *first, const char *last, uint32_t &chk) {
+        unsigned char block[4096];
+        while (first != last) {
+            size_t n = std::min(sizeof(block), static_cast<size_t>(last - first));
+            const char *bad = bech32::simd::mapChars(first, first + n, block);
+            if (bad != first + n)
+                return bad;
+            chk = bech32::Bech32Generator::polymod(block, block + n, chk);
+            first += n;
+        }
+        return last;
+    }
+
+    // Run the polymod calculation over the data part chars [first, last), starting from
+    // chk. Throws if any of the chars isn't in the charset
+    uint32_t polymodDataChars(const char *first, const char *last, uint32_t chk) {
+        const char *bad = continuePolymodOverDataChars(first, last, chk);
+        if (bad != last)
+            mapChar(*bad);
+        return chk;
+    }
+
+    // polymod of the expanded HRP chars [first, last), which are lowercased as they go
+    uint32_t polymodHrpChars(const char *first, const char *last) {
+        uint32_t chk = 1;
+        for (const char *c = first; c != last; ++c)
+            chk = bech32::Bech32Generator::step(chk, static_cast<unsigned char>(::tolower(*c)) >> 5u);
+        chk = bech32::Bech32Generator::step(chk, 0);
+        for (const char *c = first; c != last; ++c)
+            chk = bech32::Bech32Generator::step(chk, static_cast<unsigned char>(::tolower(*c)) & 0x1fu);
+        return chk;
+    }
+
+    // Return the encoding of the size chars at bstring, as decode() would find it, or Invalid
+    // if decode() would throw or find a bad checksum. Only the checksum is computed, and
+    // nothing is allocated
+    bech32::Encoding detectEncodingOf(const char *bstring, std::string::size_type size,
+                                      const bech32::LengthLimits &lengthLimits) {
+        if (size < MIN_BECH32_LENGTH || size > lengthLimits.maxBech32Length)
+            return bech32::Encoding::Invalid;
+        std::string::size_type pos = size;
+        while (pos != 0 && bstring[pos - 1] != bech32::separator)
+            --pos;
+        if (pos == 0)
+            return bech32::Encoding::Invalid;
+        --pos;
+        if (pos < MIN_HRP_LENGTH || pos > lengthLimits.maxHrpLength || size - pos - 1 < CHECKSUM_LENGTH)
+            return bech32::Encoding::Invalid;
+
+        bool atLeastOneUpper = false;
+        bool atLeastOneLower = false;
+        for (std::string::size_type i = 0; i < pos; ++i) {
+            char c = bstring[i];
+            if (c < MIN_BECH32_CHAR_VALUE || c > MAX_BECH32_CHAR_VALUE)
+                return bech32::Encoding::Invalid;
+            atLeastOneUpper |= c >= 'A' && c <= 'Z';
+            atLeastOneLower |= c >= 'a' && c <= 'z';
+        }
+
+        // The data chars are all checked against the charset below, so for the case check it
+        // is enough to know that among charset chars, only upper case letters have bit 5
+        // clear and only lower case letters have bits 5 and 6 set. These are accumulated
+        // without branches
+        unsigned char allChars = 0xff;
+        unsigned char anyChar = 0;
+        for (std::string::size_type i = pos + 1; i < size; ++i) {
+            auto c = static_cast<unsigned char>(bstring[i]);
+            allChars &= c;
+            anyChar |= static_cast<unsigned char>(c & (c << 1u));
+        }
+        atLeastOneUpper |= (allChars & 0x20u) == 0;
+        atLeastOneLower |= (anyChar & 0x40u) != 0;
+        if (atLeastOneUpper && atLeastOneLower)
+            return bech32::Encoding::Invalid;
+
+        uint32_t residue = polymodHrpChars(bstring, bstring + pos);
+        if (continuePolymodOverDataChars(bstring + pos + 1, bstring + size, residue) != bstring + size)
+            return bech32::Encoding::Invalid;
+        if (bech32::Bech32mChecksum::verifyResidue(residue))
+            return bech32::Encoding::Bech32m;
+        if (bech32::Bech32Checksum::verifyResidue(residue))
+            return bech32::Encoding::Bech32;
+        return bech32::Encoding::Invalid;
+    }
+
+    // return the checksum constant used by an encoding
+    uint32_t encodingConstant(bech32::Encoding encoding) {
+        switch (encoding) {
+            case bech32::Encoding::Bech32:
+                return bech32::Bech32Checksum::constant;
+            case bech32::Encoding::Bech32m:
+                return bech32::Bech32mChecksum::constant;
+            default:
+                throw std::runtime_error("encoding must be Bech32 or Bech32m");
+        }
+    }
+
+    // Rewrite the HRP and checksum of bstring in place, keeping its data chars. newHrp must
+    // be lowercase and within the length limits, and newHrpState is the polymod of its
+    // expansion. Returns false, leaving bstring unchanged, if its checksum is invalid.
+    //
+    // The new checksum is found without running over the data part a second time: by
+    // linearity, the polymod of the new string with a zeroed checksum is
+    // shift(newHrpState ^ oldHrpState, n) ^ residue ^ oldChecksum, where n is the number of
+    // data chars (including the checksum) and residue is the polymod of the old string.
+    bool transcodeBasis(std::string &bstring, const std::string &newHrp, uint32_t newHrpState,
+                        uint32_t newConstant, const bech32::LengthLimits &lengthLimits) {
+        rejectBStringThatIsntWellFormed(bstring, lengthLimits);
+        auto pos = static_cast<std::string::size_type>(findSeparatorPosition(bstring));
+        if (pos < MIN_HRP_LENGTH)
+            throw std::runtime_error("HRP must be at least one character");
+        if (pos > lengthLimits.maxHrpLength)
+            throw std::runtime_error("HRP must be less than " + std::to_string(lengthLimits.maxHrpLength + 1) + " characters");
+        if (bstring.size() - pos - 1 < CHECKSUM_LENGTH)
+            throw std::runtime_error("data part must be at least six characters");
+        if (newHrp.size() + bstring.size() - pos > lengthLimits.maxBech32Length)
             throw std::runtime_error("length of hrp + length of dp is too large");
+
+        const char *data = bstring.data() + pos + 1;
+        const char *end = bstring.data() + bstring.size();
+        uint32_t oldHrpState = polymodHrpChars(bstring.data(), data - 1);
+        uint32_t residue = polymodDataChars(data, end, oldHrpState);
+        if (!bech32::Bech32Checksum::verifyResidue(residue) && !bech32::Bech32mChecksum::verifyResidue(residue))
+            return false;
+
+        uint32_t oldChecksum = 0;
+        for (const char *c = end - CHECKSUM_LENGTH; c != end; ++c)
+            oldChecksum = oldChecksum << 5u | mapChar(*c);
+        uint32_t mod = bech32::Bech32Generator::shift(newHrpState ^ oldHrpState, static_cast<uint64_t>(end - data)) ^
+                       residue ^ oldChecksum ^ newConstant;
+
+        // keep the case of the original string
+        bool upper = std::any_of(bstring.begin(), bstring.end(), &::isupper);
+        bstring.replace(0, pos, newHrp);
+        std::string::size_type checksumPos = bstring.size() - CHECKSUM_LENGTH;
+        for (std::string::size_type i = 0; i < CHECKSUM_LENGTH; ++i)
+            bstring[checksumPos + i] = charset[(mod >> (5 * (CHECKSUM_LENGTH - 1 - i))) & 31u];
+        if (upper) {
+            std::transform(bstring.begin(), bstring.begin() + static_cast<std::ptrdiff_t>(newHrp.size()),
+                           bstring.begin(), &::toupper);
+            std::transform(bstring.begin() + static_cast<std::ptrdiff_t>(checksumPos), bstring.end(),
+                           bstring.begin() + static_cast<std::ptrdiff_t>(checksumPos), &::toupper);
         }
+        return true;
     }
 
-    // return true if the arg c is within the allowed charset
-    bool isAllowedChar(std::string::value_type c) {
-        return std::find(std::begin(charset), std::end(charset), c) !=
-                std::end(charset);
+    // Split a bech32 string at the last separator and map its data chars, without the
+    // checks done by decode(). Chars outside the charset are not detected, but still map to
+    // a value in range. If verify is true the checksum is checked, otherwise the encoding of
+    // the result is Invalid.
+    bech32::DecodedResult decodeTrusted(const std::string &bstring, bool verify) {
+        auto pos = bstring.find_last_of(bech32::separator);
+        if (pos == std::string::npos || pos < MIN_HRP_LENGTH || bstring.size() - pos - 1 < CHECKSUM_LENGTH)
+            return bech32::DecodedResult();
+
+        bech32::DecodedResult ret = bech32::DecodedResult();
+        ret.hrp.assign(bstring, 0, pos);
+        ret.dp.resize(bstring.size() - pos - 1);
+        const char *data = bstring.data() + pos + 1;
+        for (std::vector<unsigned char>::size_type i = 0; i < ret.dp.size(); ++i) {
+            auto c = static_cast<unsigned char>(data[i]) & 0x7fu;
+            ret.dp[i] = static_cast<unsigned char>(reverse_charset[c] & 0x1f);
+        }
+        if (verify) {
+            uint32_t residue = bech32::Bech32Generator::residue(ret.hrp, ret.dp);
+            if (bech32::Bech32mChecksum::verifyResidue(residue))
+                ret.encoding = bech32::Encoding::Bech32m;
+            else if (bech32::Bech32Checksum::verifyResidue(residue))
+                ret.encoding = bech32::Encoding::Bech32;
+            else
+                return bech32::DecodedResult();
+        }
+        stripChecksum(ret.dp);
+        return ret;
+    }
+
+    // Hash of a stream of chars, ignoring case, 8 chars at a time. The payload of a bech32
+    // string is hashed as its encoding (as the seed) followed by the chars before its
+    // checksum, so a valid string can be hashed in place, and a decoded one by mapping its
+    // data part back to chars.
+    class PayloadHasher {
+    public:
+        explicit PayloadHasher(bech32::Encoding encoding)
+                : h(0x5bd1e9955bd1e995u * (static_cast<uint64_t>(encoding) + 1)), total(0), used(0) {}
+
+        void update(const char *p, size_t n) {
+            total += n;
+            // top up a partial word first
+            for (; n != 0 && used != 0; ++p, --n)
+                addPending(*p);
+            for (; n >= 8; p += 8, n -= 8) {
+                uint64_t w;
+                std::memcpy(&w, p, 8);
+                mix(w);
+            }
+            for (; n != 0; ++p, --n)
+                addPending(*p);
+        }
+
+        uint64_t finish() {
+            if (used != 0) {
+                std::memset(pending + used, 0, 8 - used);
+                uint64_t w;
+                std::memcpy(&w, pending, 8);
+                mix(w);
+            }
+            // murmur3's finalizer
+            uint64_t x = h ^ total;
+            x ^= x >> 33u;
+            x *= 0xff51afd7ed558ccdu;
+            x ^= x >> 33u;
+            x *= 0xc4ceb9fe1a85ec53u;
+            x ^= x >> 33u;
+            return x;
+        }
+
+    private:
+        void addPending(char c) {
+            pending[used++] = c;
+            if (used == 8) {
+                uint64_t w;
+                std::memcpy(&w, pending, 8);
+                mix(w);
+                used = 0;
+            }
+        }
+
+        // mix in a word of chars, lowercasing the bytes that are 'A'..'Z'
+        void mix(uint64_t w) {
+            const uint64_t ones = 0x0101010101010101u;
+            uint64_t heptets = w & 0x7f * ones;
+            uint64_t atLeastA = heptets + (0x80 - 'A') * ones;
+            uint64_t afterZ = heptets + (0x80 - 'Z' - 1) * ones;
+            uint64_t upper = atLeastA & ~afterZ & ~w & 0x80 * ones;
+            w |= upper >> 2u;
+            h = (h ^ w) * 0x9e3779b97f4a7c15u;
+            h ^= h >> 29u;
+        }
+
+        uint64_t h;
+        uint64_t total;
+        char pending[8];
+        size_t used;
+    };
+
+    // Check and decode the data part of a bech32 string whose HRP is already known to be
+    // hrpSize chars long, continuing the checksum calculation from hrpState, the state after
+    // the expanded HRP. Returns the encoding, which is Invalid if the checksum is bad
+    bech32::Encoding decodeDataPart(const std::string &bstring, std::string::size_type hrpSize,
+                                    uint32_t hrpState, const bech32::LengthLimits &lengthLimits,
+                                    std::vector<unsigned char> &dp) {
+        rejectBStringThatIsntWellFormed(bstring, lengthLimits);
+        if (hrpSize > lengthLimits.maxHrpLength)
+            throw std::runtime_error("HRP must be less than " + std::to_string(lengthLimits.maxHrpLength + 1) + " characters");
+        dp.assign(bstring.begin() + static_cast<std::ptrdiff_t>(hrpSize) + 1, bstring.end());
+        rejectDPTooShort(dp);
+        mapDP(dp);
+        uint32_t residue = bech32::Bech32Generator::polymod(dp.data(), dp.data() + dp.size(), hrpState);
+        bech32::Encoding encoding = bech32::Encoding::Invalid;
+        if (bech32::Bech32mChecksum::verifyResidue(residue))
+            encoding = bech32::Encoding::Bech32m;
+        else if (bech32::Bech32Checksum::verifyResidue(residue))
+            encoding = bech32::Encoding::Bech32;
+        else
+            return encoding;
+        stripChecksum(dp);
+        return encoding;
+    }
+
+    // decode a bech32 string whose HRP is already known to be hrp (lowercase), continuing
+    // the checksum calculation from hrpState, the state after the expanded hrp
+    bech32::DecodedResult decodeWithHrpState(const std::string &bstring, const std::string &hrp,
+                                             uint32_t hrpState, const bech32::LengthLimits &lengthLimits) {
+        std::vector<unsigned char> dp;
+        bech32::Encoding encoding = decodeDataPart(bstring, hrp.size(), hrpState, lengthLimits, dp);
+        if (encoding == bech32::Encoding::Invalid)
+            return bech32::DecodedResult();
+        return {encoding, hrp, dp};
+    }
+
+    // return the value of a data part char, or -1 if it isn't in the charset
+    inline int8_t charValue(unsigned char c) {
+        return bech32::tables::valueOf(c);
+    }
+
+    // Encode a "human-readable part" and a packed "data part", with the checksum given by
+    // Checksum. The data part is unpacked a block at a time, and each block is both run
+    // through the polymod calculation and mapped to chars
+    template<typename Checksum>
+    std::string encodePackedWith(const std::string &hrp, const bech32::PackedData &dp,
+                                 const bech32::LengthLimits &lengthLimits) {
+        rejectHRPTooShort(hrp);
+        rejectHRPTooLong(hrp, lengthLimits.maxHrpLength);
+        rejectBothPartsTooLong(hrp, dp.size(), lengthLimits.maxBech32Length);
+
+        std::string ret = hrp;
+        convertToLowercase(ret);
+        uint32_t chk = bech32::Bech32Generator::expandedHrp(ret.data(), ret.size());
+        ret.resize(hrp.size() + 1 + dp.size() + CHECKSUM_LENGTH);
+        ret[hrp.size()] = bech32::separator;
+        char *out = &ret[hrp.size() + 1];
+
+        unsigned char block[4096];
+        for (size_t pos = 0; pos < dp.size(); pos += sizeof(block)) {
+            size_t n = std::min(sizeof(block), dp.size() - pos);
+            dp.unpack(pos, n, block);
+            chk = bech32::Bech32Generator::polymod(block, block + n, chk);
+            bech32::simd::mapValues(block, block + n, out);
+            out += n;
+        }
+        unsigned char checksum[CHECKSUM_LENGTH];
+        Checksum::create(chk, checksum);
+        bech32::simd::mapValues(checksum, checksum + CHECKSUM_LENGTH, out);
+        return ret;
+    }
+
+    // check a new HRP for transcoding, returning it lowercased
+    std::string prepareNewHrp(const std::string &newHrp, const bech32::LengthLimits &lengthLimits) {
+        rejectHRPTooShort(newHrp);
+        rejectHRPTooLong(newHrp, lengthLimits.maxHrpLength);
+        rejectBStringValuesOutOfRange(newHrp);
+        std::string ret = newHrp;
+        convertToLowercase(ret);
+        return ret;
     }
 
 }
@@ -254,61 +518,82 @@ namespace bech32 {
     // the separator character, which is '1'
     std::string stripUnknownChars(const std::string &bstring) {
         std::string ret(bstring);
-        ret.erase(
-                std::remove_if(
-                        ret.begin(), ret.end(),
-                        [](char x){return (!isAllowedChar(static_cast<char>(::tolower(x))) && x!=separator);}),
-                ret.end());
+        stripUnknownCharsInPlace(ret);
         return ret;
     }
 
+    // clean a bech32 string of any stray characters in place
+    void stripUnknownCharsInPlace(std::string &bstring) {
+        if (bstring.empty())
+            return;
+        char *first = &bstring[0];
+        char *end = simd::stripUnknownChars(first, first + bstring.size(), first);
+        bstring.resize(static_cast<std::string::size_type>(end - first));
+    }
+
     // encode a "human-readable part" and a "data part", returning a bech32 string
     std::string encodeBasis(const std::string &hrp, const std::vector<unsigned char> &dp,
-                            std::vector<unsigned char> (*checksumFunc)(const std::string &, const std::vector<unsigned char> &)) {
+                            std::vector<unsigned char> (*checksumFunc)(const std::string &, const std::vector<unsigned char> &),
+                            const LengthLimits &lengthLimits) {
         rejectHRPTooShort(hrp);
-        rejectHRPTooLong(hrp);
-        rejectBothPartsTooLong(hrp, dp);
+        rejectHRPTooLong(hrp, lengthLimits.maxHrpLength);
+        rejectBothPartsTooLong(hrp, dp, lengthLimits.maxBech32Length);
         rejectDataValuesOutOfRange(dp);
 
         std::string hrpCopy = hrp;
         convertToLowercase(hrpCopy);
         std::vector<unsigned char> checksum = checksumFunc(hrpCopy, dp);
-        std::string ret = hrpCopy + '1';
         std::vector<unsigned char> combined = cat(dp, checksum);
-        ret.reserve(ret.size() + combined.size());
-        for (unsigned char c : combined) {
-            if(c > limits::VALID_CHARSET_SIZE - 1)
-                throw std::runtime_error("data part contains invalid character");
-            ret += charset[c];
-        }
-        return ret;
+        return hrpCopy + '1' + mapToCharset(combined);
     }
 
     // encode a "human-readable part" and a "data part", returning a bech32 string
     std::string encode(const std::string &hrp, const std::vector<unsigned char> &dp) {
-        return encodeBasis(hrp, dp, &createChecksum);
+        return encodeBasis(hrp, dp, &createChecksum, limits::STANDARD_LENGTH);
+    }
+
+    // encode a "human-readable part" and a "data part" within the given length limits,
+    // returning a bech32 string
+    std::string encode(const std::string &hrp, const std::vector<unsigned char> &dp,
+                       const LengthLimits &lengthLimits) {
+        return encodeBasis(hrp, dp, &createChecksum, lengthLimits);
     }
 
     // encode a "human-readable part" and a "data part", returning a bech32 string
     std::string encodeUsingOriginalConstant(const std::string &hrp, const std::vector<unsigned char> &dp) {
-        return encodeBasis(hrp, dp, &createChecksumUsingOriginalConstant);
+        return encodeBasis(hrp, dp, &createChecksumUsingOriginalConstant, limits::STANDARD_LENGTH);
+    }
+
+    // encode a "human-readable part" and a "data part" within the given length limits,
+    // returning a bech32 string
+    std::string encodeUsingOriginalConstant(const std::string &hrp, const std::vector<unsigned char> &dp,
+                                            const LengthLimits &lengthLimits) {
+        return encodeBasis(hrp, dp, &createChecksumUsingOriginalConstant, lengthLimits);
     }
 
     // decode a bech32 string, returning the "human-readable part" and a "data part"
     DecodedResult decode(const std::string & bstring) {
-        rejectBStringThatIsntWellFormed(bstring);
+        return decode(bstring, limits::STANDARD_LENGTH);
+    }
+
+    // decode a bech32 string within the given length limits, returning the "human-readable
+    // part" and a "data part"
+    DecodedResult decode(const std::string & bstring, const LengthLimits & lengthLimits) {
+        rejectBStringThatIsntWellFormed(bstring, lengthLimits);
         std::string hrp = extractHumanReadablePart(bstring);
         std::vector<unsigned char> dp = extractDataPart(bstring);
         rejectHRPTooShort(hrp);
-        rejectHRPTooLong(hrp);
+        rejectHRPTooLong(hrp, lengthLimits.maxHrpLength);
         rejectDPTooShort(dp);
         convertToLowercase(hrp);
         mapDP(dp);
-        if (verifyChecksum(hrp, dp)) {
+        // compute the checksum once and compare it to both constants
+        uint32_t residue = Bech32Generator::residue(hrp, dp);
+        if (Bech32mChecksum::verifyResidue(residue)) {
             stripChecksum(dp);
             return {bech32::Encoding::Bech32m, hrp, dp};
         }
-        else if (verifyChecksumUsingOriginalConstant(hrp, dp)) {
+        else if (Bech32Checksum::verifyResidue(residue)) {
             stripChecksum(dp);
             return {bech32::Encoding::Bech32, hrp, dp};
         }
@@ -317,6 +602,574 @@ namespace bech32 {
         }
     }
 
+
+    // decode a bech32 string that may contain stray characters not in the allowed charset,
+    // giving the same result as decode(stripUnknownChars(bstring))
+    DecodedResult decodeDirty(const std::string & bstring, const LengthLimits & lengthLimits) {
+        // The kept chars are lowercased and checksummed in one pass. The HRP chars are run
+        // through the checksum as the high and low halves of the expanded HRP (hrp >> 5, 0,
+        // hrp & 31), which are joined at each separator to continue over the data part. If
+        // another separator follows, the data part so far was part of the HRP after all, and
+        // is added to it and its halves
+        std::string hrp;
+        std::vector<unsigned char> dp;
+        dp.reserve(bstring.size());
+        bool atLeastOneSeparator = false;
+        uint32_t hrpHigh = 1, hrpLow = 0;   // over the halves of the HRP chars
+        uint32_t chk = 0;                   // over the expanded HRP and dp
+        size_t checked = 0;                 // values of dp in chk
+        bool atLeastOneUpper = false;
+        bool atLeastOneLower = false;
+        for (char ch : bstring) {
+            auto c = static_cast<unsigned char>(ch);
+            int8_t d = charValue(c);
+            if (d == -1 && c != separator)
+                continue;
+            // kept chars are in the charset or the separator, so only letters have a case
+            if (c >= 'A' && c <= 'Z') {
+                atLeastOneUpper = true;
+                c = static_cast<unsigned char>(c | 0x20u);
+            }
+            else {
+                atLeastOneLower |= c >= 'a';
+            }
+            if (c == separator) {
+                if (atLeastOneSeparator) {
+                    std::string::size_type hrpSize = hrp.size();
+                    hrp += separator;
+                    for (unsigned char value : dp)
+                        hrp += charset[value];
+                    for (std::string::size_type i = hrpSize; i < hrp.size(); ++i) {
+                        auto h = static_cast<unsigned char>(hrp[i]);
+                        hrpHigh = Bech32Generator::step(hrpHigh, static_cast<unsigned char>(h >> 5u));
+                        hrpLow = Bech32Generator::step(hrpLow, static_cast<unsigned char>(h & 0x1fu));
+                    }
+                }
+                atLeastOneSeparator = true;
+                chk = Bech32Generator::step(hrpHigh, 0);
+                for (std::string::size_type i = 0; i < hrp.size(); ++i)
+                    chk = Bech32Generator::step(chk, 0);
+                chk ^= hrpLow;
+                dp.clear();
+                checked = 0;
+            }
+            else if (!atLeastOneSeparator) {
+                hrpHigh = Bech32Generator::step(hrpHigh, static_cast<unsigned char>(c >> 5u));
+                hrpLow = Bech32Generator::step(hrpLow, static_cast<unsigned char>(c & 0x1fu));
+                hrp += static_cast<char>(c);
+            }
+            else {
+                // the data part is folded into the checksum a whole fold at a time
+                dp.push_back(static_cast<unsigned char>(d));
+                if (dp.size() - checked == Bech32Generator::checksumLength) {
+                    chk = Bech32Generator::folded(dp.data() + checked, dp.data() + dp.size(), chk);
+                    checked = dp.size();
+                }
+            }
+        }
+        chk = Bech32Generator::serial(dp.data() + checked, dp.data() + dp.size(), chk);
+
+        // the same checks, in the same order, as decode() does on the stripped string
+        std::string::size_type strippedSize = hrp.size() + (atLeastOneSeparator ? 1 : 0) + dp.size();
+        if (strippedSize < MIN_BECH32_LENGTH)
+            throw std::runtime_error("bech32 string too short");
+        if (strippedSize > lengthLimits.maxBech32Length)
+            throw std::runtime_error("bech32 string too long");
+        if (atLeastOneUpper && atLeastOneLower)
+            throw std::runtime_error("bech32 string is mixed case");
+        if (!atLeastOneSeparator)
+            throw std::runtime_error("bech32 string is missing separator character");
+        rejectHRPTooShort(hrp);
+        rejectHRPTooLong(hrp, lengthLimits.maxHrpLength);
+        rejectDPTooShort(dp);
+
+        if (Bech32mChecksum::verifyResidue(chk)) {
+            stripChecksum(dp);
+            return {bech32::Encoding::Bech32m, hrp, dp};
+        }
+        else if (Bech32Checksum::verifyResidue(chk)) {
+            stripChecksum(dp);
+            return {bech32::Encoding::Bech32, hrp, dp};
+        }
+        else {
+            return DecodedResult();
+        }
+    }
+
+    // return true if bstring is a valid bech32 string within the given length limits
+    bool isValid(const std::string & bstring, const LengthLimits & lengthLimits) {
+        return detectEncodingOf(bstring.data(), bstring.size(), lengthLimits) != Encoding::Invalid;
+    }
+
+    // return the encoding of bstring if it is a valid bech32 string within the given length
+    // limits, otherwise Invalid
+    Encoding detectEncoding(const std::string & bstring, const LengthLimits & lengthLimits) {
+        return detectEncodingOf(bstring.data(), bstring.size(), lengthLimits);
+    }
+
+    // the HRP of the view, lowercased
+    std::string DecodedView::hrp() const {
+        std::string ret(hrpChars, hrpSize);
+        convertToLowercase(ret);
+        return ret;
+    }
+
+    // all values of the data part of the view
+    std::vector<unsigned char> DecodedView::dp() const {
+        std::vector<unsigned char> ret(dataSize);
+        simd::mapChars(dataChars, dataChars + dataSize, ret.data());
+        return ret;
+    }
+
+    // the value of a data part char, which must be in the charset
+    unsigned char DecodedView::valueOf(char c) {
+        return static_cast<unsigned char>(reverse_charset[static_cast<unsigned char>(c) & 0x7fu]);
+    }
+
+    // decode a bech32 string into a view of it, verifying its checksum
+    DecodedView decodeView(const std::string & bstring, const LengthLimits & lengthLimits) {
+        return decodeView(bstring.data(), bstring.size(), lengthLimits);
+    }
+
+    // decode the size chars at bstring into a view of them, verifying their checksum
+    DecodedView decodeView(const char * bstring, size_t size, const LengthLimits & lengthLimits) {
+        Encoding encoding = detectEncodingOf(bstring, size, lengthLimits);
+        if (encoding == Encoding::Invalid)
+            return DecodedView();
+        // a valid string has exactly one separator in the data part's place
+        size_t pos = size - CHECKSUM_LENGTH - 1;
+        while (bstring[pos] != separator)
+            --pos;
+        return DecodedView(encoding, bstring, pos, bstring + pos + 1, size - pos - 1 - CHECKSUM_LENGTH);
+    }
+
+    // pack the given values, which must each be less than 32
+    PackedData::PackedData(const std::vector<unsigned char> &values) : count(0) {
+        append(values.data(), values.data() + values.size());
+    }
+
+    // set the bits of the next value, which bytes already has room for
+    void PackedData::put(unsigned char value) {
+        size_t bit = 5 * count;
+        unsigned window = static_cast<unsigned>(value) << (11 - bit % 8);
+        bytes[bit / 8] |= static_cast<unsigned char>(window >> 8u);
+        bytes[bit / 8 + 1] |= static_cast<unsigned char>(window);
+        ++count;
+    }
+
+    // append a value, which must be less than 32
+    void PackedData::push_back(unsigned char value) {
+        if (value > VALID_CHARSET_SIZE - 1)
+            throw std::runtime_error("data value is out of range");
+        bytes.resize(packedSize(count + 1));
+        put(value);
+    }
+
+    // append the values [first, last), which must each be less than 32
+    void PackedData::append(const unsigned char *first, const unsigned char *last) {
+        unsigned char all = 0;
+        for (const unsigned char *p = first; p != last; ++p)
+            all |= *p;
+        if (all > VALID_CHARSET_SIZE - 1)
+            throw std::runtime_error("data value is out of range");
+        if (first == last)
+            return;
+
+        bytes.resize(packedSize(count + static_cast<size_t>(last - first)));
+        for (; first != last && count % 8 != 0; ++first)
+            put(*first);
+        // now aligned, so each 8 values fill 5 whole bytes
+        unsigned char *out = bytes.data() + count / 8 * 5;
+        for (; last - first >= 8; first += 8, out += 5, count += 8) {
+            uint64_t bits = 0;
+            for (unsigned i = 0; i < 8; ++i)
+                bits = bits << 5u | first[i];
+            out[0] = static_cast<unsigned char>(bits >> 32u);
+            out[1] = static_cast<unsigned char>(bits >> 24u);
+            out[2] = static_cast<unsigned char>(bits >> 16u);
+            out[3] = static_cast<unsigned char>(bits >> 8u);
+            out[4] = static_cast<unsigned char>(bits);
+        }
+        for (; first != last; ++first)
+            put(*first);
+    }
+
+    // write the n values starting at index pos to out
+    void PackedData::unpack(size_t pos, size_t n, unsigned char *out) const {
+        size_t end = pos + n;
+        for (; pos != end && pos % 8 != 0; ++pos)
+            *out++ = (*this)[pos];
+        // now aligned, so each 5 bytes hold 8 whole values
+        const unsigned char *in = bytes.data() + pos / 8 * 5;
+        for (; end - pos >= 8; pos += 8, in += 5, out += 8) {
+            uint64_t bits = static_cast<uint64_t>(in[0]) << 32u | static_cast<uint64_t>(in[1]) << 24u |
+                            static_cast<uint64_t>(in[2]) << 16u | static_cast<uint64_t>(in[3]) << 8u | in[4];
+            for (unsigned i = 0; i < 8; ++i)
+                out[i] = static_cast<unsigned char>(bits >> (35 - 5 * i) & 31u);
+        }
+        for (; pos != end; ++pos)
+            *out++ = (*this)[pos];
+    }
+
+    // all the values, as in DecodedResult::dp
+    std::vector<unsigned char> PackedData::unpack() const {
+        std::vector<unsigned char> ret(count);
+        unpack(0, count, ret.data());
+        return ret;
+    }
+
+    // decode a bech32 string, packing the data part
+    DecodedPackedResult decodePacked(const std::string &bstring, const LengthLimits &lengthLimits) {
+        DecodedView view = decodeView(bstring, lengthLimits);
+        if (view.encoding() == Encoding::Invalid) {
+            // let decode() throw the same error, or give its result for a bad checksum
+            DecodedResult result = decode(bstring, lengthLimits);
+            return {result.encoding, result.hrp, PackedData(result.dp)};
+        }
+
+        DecodedPackedResult ret = {view.encoding(), view.hrp(), PackedData()};
+        ret.dp.reserve(view.size());
+        unsigned char block[4096];
+        const char *data = view.hrpData() + view.hrpLength() + 1;
+        for (size_t pos = 0; pos < view.size(); pos += sizeof(block)) {
+            size_t n = std::min(sizeof(block), view.size() - pos);
+            simd::mapChars(data + pos, data + pos + n, block);
+            ret.dp.append(block, block + n);
+        }
+        return ret;
+    }
+
+    // encode a "human-readable part" and a packed "data part", returning a bech32m string
+    std::string encodePacked(const std::string &hrp, const PackedData &dp, const LengthLimits &lengthLimits) {
+        return encodePackedWith<Bech32mChecksum>(hrp, dp, lengthLimits);
+    }
+
+    // encode a "human-readable part" and a packed "data part", returning a bech32 string
+    std::string encodePackedUsingOriginalConstant(const std::string &hrp, const PackedData &dp,
+                                                  const LengthLimits &lengthLimits) {
+        return encodePackedWith<Bech32Checksum>(hrp, dp, lengthLimits);
+    }
+
+    // hash of the encoding, HRP (ignoring case) and data part of a decoded payload
+    uint64_t payloadHash(const DecodedResult &decoded) {
+        PayloadHasher hasher(decoded.encoding);
+        hasher.update(decoded.hrp.data(), decoded.hrp.size());
+        hasher.update(&separator, 1);
+        char block[256];
+        for (size_t pos = 0; pos < decoded.dp.size(); pos += sizeof(block)) {
+            size_t n = std::min(sizeof(block), decoded.dp.size() - pos);
+            for (size_t i = 0; i < n; ++i)
+                block[i] = charset[decoded.dp[pos + i] & 31u];
+            hasher.update(block, n);
+        }
+        return hasher.finish();
+    }
+
+    // the payloadHash() of decode(bstring), computed from the string itself
+    uint64_t canonicalHash(const std::string &bstring, const LengthLimits &lengthLimits) {
+        Encoding encoding = detectEncodingOf(bstring.data(), bstring.size(), lengthLimits);
+        PayloadHasher hasher(encoding);
+        // a valid string's chars before the checksum are its lowercased HRP, the separator
+        // and the chars of its data part
+        size_t n = encoding == Encoding::Invalid ? bstring.size() : bstring.size() - CHECKSUM_LENGTH;
+        hasher.update(bstring.data(), n);
+        return hasher.finish();
+    }
+
+    // two strings are equal if they are the same, or are both valid and differ only in case
+    bool CanonicalEqual::operator()(const std::string &a, const std::string &b) const {
+        if (a == b)
+            return true;
+        return caseless::equals(a.data(), a.size(), b) &&
+               detectEncodingOf(a.data(), a.size(), lengthLimits) != Encoding::Invalid &&
+               detectEncodingOf(b.data(), b.size(), lengthLimits) != Encoding::Invalid;
+    }
+
+    // decode a bech32 string with the given amount of checking, returning the
+    // "human-readable part" and a "data part"
+    DecodedResult decode(const std::string & bstring, DecodeMode mode, const LengthLimits & lengthLimits) {
+        switch (mode) {
+            case DecodeMode::ChecksumOnly:
+                return decodeTrusted(bstring, true);
+            case DecodeMode::LayoutOnly:
+                return decodeTrusted(bstring, false);
+            default:
+                return decode(bstring, lengthLimits);
+        }
+    }
+
+    const size_t ExpectedHrps::npos;
+
+    ExpectedHrps::ExpectedHrps(const std::vector<std::string> & expectedHrps) {
+        hrps.reserve(expectedHrps.size());
+        states.reserve(expectedHrps.size());
+        for (const std::string &expectedHrp : expectedHrps) {
+            rejectHRPTooShort(expectedHrp);
+            rejectBStringValuesOutOfRange(expectedHrp);
+            std::string hrp = expectedHrp;
+            convertToLowercase(hrp);
+            states.push_back(Bech32Generator::expandedHrp(hrp.data(), hrp.size()));
+            hrps.push_back(hrp);
+        }
+    }
+
+    // return the index of the HRP equal, ignoring case, to the size chars at hrp, or npos
+    // if there is none
+    size_t ExpectedHrps::find(const char * hrp, size_t size) const {
+        for (size_t i = 0; i < hrps.size(); ++i) {
+            if (caseless::equals(hrp, size, hrps[i]))
+                return i;
+        }
+        return npos;
+    }
+
+    // seed the state with hrp, lowercased
+    ChecksumState::ChecksumState(const std::string & hrp) : chk(1), count(0) {
+        rejectHRPTooShort(hrp);
+        rejectBStringValuesOutOfRange(hrp);
+        std::string lower = hrp;
+        convertToLowercase(lower);
+        chk = Bech32Generator::expandedHrp(lower.data(), lower.size());
+    }
+
+    // feed the values in [first, last)
+    void ChecksumState::update(const unsigned char * first, const unsigned char * last) {
+        if (std::any_of(first, last, [](unsigned char v) { return v > VALID_CHARSET_SIZE - 1; }))
+            throw std::runtime_error("data value is out of range");
+        chk = Bech32Generator::polymod(first, last, chk);
+        count += static_cast<size_t>(last - first);
+    }
+
+    // the checksum for the given encoding of the hrp and the values fed so far
+    std::vector<unsigned char> ChecksumState::finalize(Encoding encoding) const {
+        std::vector<unsigned char> ret(CHECKSUM_LENGTH);
+        finalize(encoding, ret.data());
+        return ret;
+    }
+
+    // write the checksum for the given encoding of the hrp and the values fed so far to out
+    void ChecksumState::finalize(Encoding encoding, unsigned char * out) const {
+        if (encoding == Encoding::Bech32m)
+            Bech32mChecksum::create(chk, out);
+        else if (encoding == Encoding::Bech32)
+            Bech32Checksum::create(chk, out);
+        else
+            throw std::runtime_error("encoding must be Bech32 or Bech32m");
+    }
+
+    // the encoding whose checksum the values fed so far end with, or Invalid
+    Encoding ChecksumState::verify() const {
+        if (Bech32mChecksum::verifyResidue(chk))
+            return Encoding::Bech32m;
+        if (Bech32Checksum::verifyResidue(chk))
+            return Encoding::Bech32;
+        return Encoding::Invalid;
+    }
+
+    namespace detail {
+
+        // check that hrp and dp can be encoded, and compute the checksum
+        EncodedChars::EncodedChars(const std::string & hrp, const std::vector<unsigned char> & dp,
+                                   Encoding encoding, LetterCase letterCase, const LengthLimits & lengthLimits)
+                : hrp(hrp), dp(dp), letterCase(letterCase), pos(0) {
+            if (encoding == Encoding::Invalid)
+                throw std::runtime_error("encoding must be Bech32 or Bech32m");
+            rejectHRPTooLong(hrp, lengthLimits.maxHrpLength);
+            rejectBothPartsTooLong(hrp, dp, lengthLimits.maxBech32Length);
+            ChecksumState state(hrp);
+            state.update(dp);
+            state.finalize(encoding, checksum);
+        }
+
+        // write up to n of the chars not yet written to out
+        size_t EncodedChars::read(char * out, size_t n) {
+            char *first = out;
+            char *last = out + std::min(n, size() - pos);
+            for (; out != last && pos < hrp.size(); ++out, ++pos)
+                *out = static_cast<char>(::tolower(static_cast<unsigned char>(hrp[pos])));
+            if (out != last && pos == hrp.size()) {
+                *out++ = separator;
+                ++pos;
+            }
+            size_t dataPos = hrp.size() + 1;
+            if (out != last && pos < dataPos + dp.size()) {
+                size_t k = std::min(static_cast<size_t>(last - out), dataPos + dp.size() - pos);
+                const unsigned char *values = dp.data() + (pos - dataPos);
+                simd::mapValues(values, values + k, out);
+                out += k;
+                pos += k;
+            }
+            if (out != last) {
+                size_t k = static_cast<size_t>(last - out);
+                const unsigned char *values = checksum + (pos - dataPos - dp.size());
+                simd::mapValues(values, values + k, out);
+                out += k;
+                pos += k;
+            }
+            // the chars are lowercase letters and digits, so only letters change
+            if (letterCase == Uppercase) {
+                std::transform(first, out, first, [](char c) {
+                    return static_cast<char>(c >= 'a' && c <= 'z' ? c - ('a' - 'A') : c);
+                });
+            }
+            return static_cast<size_t>(out - first);
+        }
+
+    }
+
+    // encode hrp and dp, appending the string to out
+    void encodeTo(std::string & out, const std::string & hrp, const std::vector<unsigned char> & dp,
+                  Encoding encoding, LetterCase letterCase, const LengthLimits & lengthLimits) {
+        detail::EncodedChars chars(hrp, dp, encoding, letterCase, lengthLimits);
+        size_t oldSize = out.size();
+        out.resize(oldSize + chars.size());
+        chars.read(&out[oldSize], chars.size());
+    }
+
+    // decode a bech32 string only if its "human-readable part" is expectedHrp, ignoring case
+    DecodedResult decode(const std::string & bstring, const std::string & expectedHrp,
+                         const LengthLimits & lengthLimits) {
+        rejectHRPTooShort(expectedHrp);
+        auto pos = bstring.find_last_of(separator);
+        if (pos == std::string::npos || !caseless::equals(bstring.data(), pos, expectedHrp))
+            return DecodedResult();
+        // callers usually decode many strings with the same HRP, so the checksum state after
+        // the last one is kept for each thread
+        thread_local std::string lastHrp;
+        thread_local uint32_t lastState = 0;
+        if (!caseless::equals(expectedHrp.data(), expectedHrp.size(), lastHrp)) {
+            lastHrp = expectedHrp;
+            convertToLowercase(lastHrp);
+            lastState = Bech32Generator::expandedHrp(lastHrp.data(), lastHrp.size());
+        }
+        return decodeWithHrpState(bstring, lastHrp, lastState, lengthLimits);
+    }
+
+    // decode a bech32 string only if its "human-readable part" is one of expectedHrps,
+    // ignoring case
+    DecodedResult decode(const std::string & bstring, const ExpectedHrps & expectedHrps,
+                         const LengthLimits & lengthLimits) {
+        auto pos = bstring.find_last_of(separator);
+        if (pos == std::string::npos)
+            return DecodedResult();
+        size_t index = expectedHrps.find(bstring.data(), pos);
+        if (index == ExpectedHrps::npos)
+            return DecodedResult();
+        return decodeWithHrpState(bstring, expectedHrps.hrp(index), expectedHrps.checksumState(index), lengthLimits);
+    }
+
+    const HrpId HrpRegistry::unknownHrp;
+
+    // The ids are looked up with a perfect hash: a seed is searched for that maps every HRP
+    // to its own slot of a table at least twice the number of HRPs, so a lookup is one hash,
+    // one slot and one compare
+    HrpRegistry::HrpRegistry(const std::vector<std::string> & registeredHrps) {
+        if (registeredHrps.size() >= unknownHrp)
+            throw std::runtime_error("too many HRPs for an HrpRegistry");
+        hrps.reserve(registeredHrps.size());
+        states.reserve(registeredHrps.size());
+        for (const std::string &registeredHrp : registeredHrps) {
+            rejectHRPTooShort(registeredHrp);
+            rejectBStringValuesOutOfRange(registeredHrp);
+            std::string hrp = registeredHrp;
+            convertToLowercase(hrp);
+            if (std::find(hrps.begin(), hrps.end(), hrp) != hrps.end())
+                throw std::runtime_error("HRP is registered more than once");
+            states.push_back(Bech32Generator::expandedHrp(hrp.data(), hrp.size()));
+            hrps.push_back(hrp);
+        }
+
+        size_t tableSize = 1;
+        while (tableSize < 2 * hrps.size())
+            tableSize *= 2;
+        for (seed = 0; ; ++seed) {
+            // grow the table if no seed is found quickly
+            if (seed != 0 && seed % 64 == 0)
+                tableSize *= 2;
+            slots.assign(tableSize, unknownHrp);
+            HrpId id = 0;
+            for (; id < hrps.size(); ++id) {
+                HrpId &slot = slots[caseless::hash(hrps[id].data(), hrps[id].size(), seed) & (tableSize - 1)];
+                if (slot != unknownHrp)
+                    break;
+                slot = id;
+            }
+            if (id == hrps.size())
+                break;
+        }
+    }
+
+    // return the id of the HRP equal, ignoring case, to the size chars at hrp, or unknownHrp
+    // if it isn't registered
+    HrpId HrpRegistry::find(const char * hrp, size_t size) const {
+        HrpId id = slots[caseless::hash(hrp, size, seed) & (slots.size() - 1)];
+        if (id != unknownHrp && caseless::equals(hrp, size, hrps[id]))
+            return id;
+        return unknownHrp;
+    }
+
+    // decode a bech32 string whose "human-readable part" is one of those in registry,
+    // returning the id of the HRP
+    DecodedIdResult decode(const std::string & bstring, const HrpRegistry & registry,
+                           const LengthLimits & lengthLimits) {
+        DecodedIdResult ret = {Encoding::Invalid, HrpRegistry::unknownHrp, std::vector<unsigned char>()};
+        auto pos = bstring.find_last_of(separator);
+        if (pos == std::string::npos)
+            return ret;
+        HrpId id = registry.find(bstring.data(), pos);
+        if (id == HrpRegistry::unknownHrp)
+            return ret;
+        ret.encoding = decodeDataPart(bstring, pos, registry.checksumState(id), lengthLimits, ret.dp);
+        if (ret.encoding == Encoding::Invalid)
+            ret.dp.clear();
+        else
+            ret.hrpId = id;
+        return ret;
+    }
+
+    // re-encode a bech32 string with a new "human-readable part" and encoding, keeping its
+    // data part
+    std::string transcode(const std::string & bstring, const std::string & newHrp, Encoding newEncoding,
+                          const LengthLimits & lengthLimits) {
+        std::string ret = bstring;
+        transcodeInPlace(ret, newHrp, newEncoding, lengthLimits);
+        return ret;
+    }
+
+    // re-encode a bech32 string in place with a new "human-readable part" and encoding,
+    // keeping its data part
+    void transcodeInPlace(std::string & bstring, const std::string & newHrp, Encoding newEncoding,
+                          const LengthLimits & lengthLimits) {
+        uint32_t newConstant = encodingConstant(newEncoding);
+        std::string hrp = prepareNewHrp(newHrp, lengthLimits);
+        uint32_t hrpState = Bech32Generator::expandedHrp(hrp.data(), hrp.size());
+        if (!transcodeBasis(bstring, hrp, hrpState, newConstant, lengthLimits))
+            throw std::runtime_error("bech32 string has invalid checksum");
+    }
+
+    // re-encode bech32 strings in place with a new "human-readable part" and encoding,
+    // keeping their data parts. returns the indexes of the strings that could not be
+    // transcoded
+    std::vector<size_t> transcodeInPlace(std::vector<std::string> & bstrings, const std::string & newHrp,
+                                         Encoding newEncoding, const LengthLimits & lengthLimits) {
+        uint32_t newConstant = encodingConstant(newEncoding);
+        std::string hrp = prepareNewHrp(newHrp, lengthLimits);
+        uint32_t hrpState = Bech32Generator::expandedHrp(hrp.data(), hrp.size());
+        std::vector<size_t> failed;
+        for (size_t i = 0; i < bstrings.size(); ++i) {
+            bool transcoded;
+            try {
+                transcoded = transcodeBasis(bstrings[i], hrp, hrpState, newConstant, lengthLimits);
+            }
+            catch (std::exception &) {
+                transcoded = false;
+            }
+            if (!transcoded)
+                failed.push_back(i);
+        }
+        return failed;
+    }
+
 }
 
 // C bindings - functions
@@ -657,3 +1510,32 @@ bech32_error bech32_decode(bech32_DecodedResult *decodedResult, char const *str)
 
     return E_BECH32_SUCCESS;
 }
+
+/**
+ * check whether a string is a valid bech32 string, without decoding it
+ *
+ * @param str the string to check
+ *
+ * @return 1 if str is a valid bech32 string, 0 if not (or if str is NULL)
+ */
+extern "C"
+int bech32_is_valid(const char *str) {
+    if(str == nullptr)
+        return 0;
+    return detectEncodingOf(str, strlen(str), bech32::limits::STANDARD_LENGTH) != bech32::Encoding::Invalid;
+}
+
+/**
+ * find the encoding of a bech32 string, without decoding it
+ *
+ * @param str the string to check
+ *
+ * @return ENCODING_BECH32 or ENCODING_BECH32M if str is a valid bech32 string, otherwise
+ * ENCODING_INVALID
+ */
+extern "C"
+bech32_encoding bech32_detect_encoding(const char *str) {
+    if(str == nullptr)
+        return ENCODING_INVALID;
+    return static_cast<bech32_encoding>(detectEncodingOf(str, strlen(str), bech32::limits::STANDARD_LENGTH));
+}
@@ -0,0 +1,156 @@
+#include "bech32_base32.h"
+#include "bech32_packing.h"
+#include "bech32_simd.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+    // groups regrouped and mapped per block, so the values stay in L1 cache
+    const size_t blockGroups = 512;
+
+    // append the chars of whole groups of 5 bytes at data to out
+    void encodeGroups(const unsigned char *data, size_t groups, std::string &out) {
+        unsigned char values[8 * blockGroups];
+        size_t oldSize = out.size();
+        out.resize(oldSize + 8 * groups);
+        char *chars = &out[0] + oldSize;
+        while (groups != 0) {
+            size_t n = std::min(groups, blockGroups);
+            bech32::simd::unpackGroups(data, n, values);
+            bech32::simd::mapValues(values, values + 8 * n, chars);
+            data += 5 * n;
+            chars += 8 * n;
+            groups -= n;
+        }
+    }
+
+    // map chars to their values, throwing if any isn't in the charset
+    void mapBase32Chars(const char *first, const char *last, unsigned char *values) {
+        if (bech32::simd::mapChars(first, last, values) != last)
+            throw std::runtime_error("base32 string contains invalid character");
+    }
+
+    // append the bytes of whole groups of 8 chars to out, which is cut back to keep bytes if
+    // a char isn't in the charset
+    void decodeGroups(const char *chars, size_t groups, std::vector<unsigned char> &out, size_t keep) {
+        unsigned char values[8 * blockGroups];
+        size_t oldSize = out.size();
+        out.resize(oldSize + 5 * groups);
+        unsigned char *data = out.data() + oldSize;
+        while (groups != 0) {
+            size_t n = std::min(groups, blockGroups);
+            if (bech32::simd::mapChars(chars, chars + 8 * n, values) != chars + 8 * n) {
+                out.resize(keep);
+                throw std::runtime_error("base32 string contains invalid character");
+            }
+            bech32::simd::packGroups(values, n, data);
+            chars += 8 * n;
+            data += 5 * n;
+            groups -= n;
+        }
+    }
+
+}
+
+
+namespace bech32 {
+
+    // return the base32 chars of the size bytes at data
+    std::string encodeBase32(const unsigned char * data, size_t size) {
+        std::string ret;
+        ret.reserve((8 * size + 4) / 5);
+        Base32Encoder encoder;
+        encoder.update(data, size, ret);
+        encoder.finish(ret);
+        return ret;
+    }
+
+    std::string encodeBase32(const std::vector<unsigned char> & data) {
+        return encodeBase32(data.data(), data.size());
+    }
+
+    // return the bytes written as base32 chars
+    std::vector<unsigned char> decodeBase32(const std::string & chars) {
+        std::vector<unsigned char> ret;
+        ret.reserve(5 * chars.size() / 8);
+        Base32Decoder decoder;
+        decoder.update(chars.data(), chars.size(), ret);
+        decoder.finish(ret);
+        return ret;
+    }
+
+    // append the chars of the next size bytes to out
+    void Base32Encoder::update(const unsigned char * data, size_t size, std::string & out) {
+        if (pendingSize != 0 && size != 0) {
+            size_t n = std::min(size, 5 - pendingSize);
+            std::memcpy(pending + pendingSize, data, n);
+            pendingSize += n;
+            data += n;
+            size -= n;
+            if (pendingSize < 5)
+                return;
+            encodeGroups(pending, 1, out);
+            pendingSize = 0;
+        }
+        encodeGroups(data, size / 5, out);
+        pendingSize = size % 5;
+        if (pendingSize != 0)
+            std::memcpy(pending, data + size - pendingSize, pendingSize);
+    }
+
+    // append the chars of the bytes held back, padded with zero bits
+    void Base32Encoder::finish(std::string & out) {
+        if (pendingSize == 0)
+            return;
+        unsigned char values[8];
+        size_t n = (8 * pendingSize + 4) / 5;
+        std::memset(pending + pendingSize, 0, sizeof(pending) - pendingSize);
+        packing::unpackValues(pending, n, values);
+        size_t oldSize = out.size();
+        out.resize(oldSize + n);
+        simd::mapValues(values, values + n, &out[oldSize]);
+        pendingSize = 0;
+    }
+
+    // append the bytes of the next size chars to out
+    void Base32Decoder::update(const char * chars, size_t size, std::vector<unsigned char> & out) {
+        if (pendingSize + size < 8) {
+            mapBase32Chars(chars, chars + size, pending + pendingSize);
+            pendingSize += size;
+            return;
+        }
+        // map the chars completing the group held back, and those to be held back after this
+        // chunk, before anything is appended, so neither can leave out changed
+        size_t head = pendingSize == 0 ? 0 : 8 - pendingSize;
+        size_t rest = (size - head) % 8;
+        unsigned char tail[8];
+        mapBase32Chars(chars, chars + head, pending + pendingSize);
+        mapBase32Chars(chars + size - rest, chars + size, tail);
+        size_t oldSize = out.size();
+        if (head != 0) {
+            out.resize(oldSize + 5);
+            simd::packGroups(pending, 1, out.data() + oldSize);
+        }
+        decodeGroups(chars + head, (size - head) / 8, out, oldSize);
+        std::memcpy(pending, tail, rest);
+        pendingSize = rest;
+    }
+
+    // append the bytes of the chars held back, checking their padding
+    void Base32Decoder::finish(std::vector<unsigned char> & out) {
+        size_t n = pendingSize;
+        pendingSize = 0;
+        if (n == 0)
+            return;
+        // the padding must be less than a char and all zero
+        size_t bytes = 5 * n / 8;
+        unsigned char packed[5];
+        packing::packValues(pending, n, packed);
+        if (5 * n - 8 * bytes >= 5 || packed[bytes] != 0)
+            throw std::runtime_error("base32 string has invalid padding");
+        out.insert(out.end(), packed, packed + bytes);
+    }
+
+}
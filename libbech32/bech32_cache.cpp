@@ -0,0 +1,25 @@
+#include "bech32_cache.h"
+#include <stdexcept>
+
+namespace bech32 {
+
+    // decode bstring as decode(bstring, lengthLimits) does, or return the cached result
+    DecodedResult DecodeCache::decode(const std::string &bstring) {
+        return cache.get(bstring, [this](const std::string &key) {
+            return bech32::decode(key, lengthLimits);
+        });
+    }
+
+    // encode hrp and dp with the given encoding, or return the cached string
+    std::string EncodeCache::encode(const std::string &hrp, const std::vector<unsigned char> &dp, Encoding encoding) {
+        if (encoding == Encoding::Invalid)
+            throw std::runtime_error("encoding must be Bech32 or Bech32m");
+        DecodedResult key = {encoding, hrp, dp};
+        return cache.get(key, [this](const DecodedResult &payload) {
+            return payload.encoding == Encoding::Bech32
+                   ? encodeUsingOriginalConstant(payload.hrp, payload.dp, lengthLimits)
+                   : bech32::encode(payload.hrp, payload.dp, lengthLimits);
+        });
+    }
+
+}
@@ -0,0 +1,373 @@
+#include "bech32_canonical.h"
+#include "bech32_caseless.h"
+#include "bech32_packing.h"
+#include "bech32_simd.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+    // keys of buckets at most this big are insertion sorted
+    const size_t maxInsertionSort = 32;
+
+    // chunks with fewer keys than this are sorted on one thread
+    const size_t minParallelSort = 65536;
+
+    // bytes read from a spilled run at a time
+    const size_t runBufferSize = 65536;
+
+    // Each spill gets its own file, which holds at most about memoryLimit bytes, so capping
+    // memoryLimit at half of what a long holds keeps every offset fseek() is given in range
+    // where long is 32 bits
+    const uint64_t maxMemoryLimit = static_cast<uint64_t>(std::numeric_limits<long>::max()) / 2;
+
+    // insertion sort the n keys of width bytes at keys, whose bytes before depth are equal.
+    // tmp holds one key
+    void insertionSort(unsigned char *keys, size_t n, size_t width, size_t depth, unsigned char *tmp) {
+        for (size_t i = 1; i < n; ++i) {
+            unsigned char *key = keys + i * width;
+            if (std::memcmp(key - width + depth, key + depth, width - depth) <= 0)
+                continue;
+            std::memcpy(tmp, key, width);
+            size_t j = i;
+            for (; j > 0 && std::memcmp(keys + (j - 1) * width + depth, tmp + depth, width - depth) > 0; --j)
+                std::memcpy(keys + j * width, keys + (j - 1) * width, width);
+            std::memcpy(keys + j * width, tmp, width);
+        }
+    }
+
+    // Distribute the n keys of width bytes at keys into 256 buckets by their byte at depth,
+    // using scratch, and set starts[b] to the index of bucket b (starts[256] = n)
+    void distribute(unsigned char *keys, unsigned char *scratch, size_t n, size_t width, size_t depth,
+                    size_t starts[257]) {
+        std::fill(starts, starts + 257, 0);
+        for (size_t i = 0; i < n; ++i)
+            ++starts[keys[i * width + depth] + 1];
+        for (size_t b = 0; b < 256; ++b) {
+            // all in one bucket: nothing moves
+            if (starts[b + 1] == n) {
+                std::fill(starts + b + 1, starts + 257, n);
+                return;
+            }
+            starts[b + 1] += starts[b];
+        }
+        size_t next[256];
+        std::copy(starts, starts + 256, next);
+        for (size_t i = 0; i < n; ++i) {
+            const unsigned char *key = keys + i * width;
+            std::memcpy(scratch + next[key[depth]]++ * width, key, width);
+        }
+        std::memcpy(keys, scratch, n * width);
+    }
+
+    // MSD radix sort the n keys of width bytes at keys, whose bytes before depth are equal
+    void radixSort(unsigned char *keys, unsigned char *scratch, size_t n, size_t width, size_t depth,
+                   unsigned char *tmp) {
+        for (; depth < width; ++depth) {
+            if (n <= maxInsertionSort) {
+                insertionSort(keys, n, width, depth, tmp);
+                return;
+            }
+            size_t starts[257];
+            distribute(keys, scratch, n, width, depth, starts);
+            // recurse into all but the biggest bucket, which is sorted by the loop
+            size_t biggest = 0;
+            for (size_t b = 1; b < 256; ++b) {
+                if (starts[b + 1] - starts[b] > starts[biggest + 1] - starts[biggest])
+                    biggest = b;
+            }
+            for (size_t b = 0; b < 256; ++b) {
+                if (b != biggest)
+                    radixSort(keys + starts[b] * width, scratch + starts[b] * width, starts[b + 1] - starts[b],
+                              width, depth + 1, tmp);
+            }
+            keys += starts[biggest] * width;
+            scratch += starts[biggest] * width;
+            n = starts[biggest + 1] - starts[biggest];
+        }
+    }
+
+    // Sort the n keys of width bytes at keys, using scratch. The first byte is distributed on
+    // this thread, then the buckets are sorted by up to the given number of threads
+    void sortKeys(unsigned char *keys, unsigned char *scratch, size_t n, size_t width, size_t threads) {
+        if (threads < 2 || n < minParallelSort) {
+            std::vector<unsigned char> tmp(width);
+            radixSort(keys, scratch, n, width, 0, tmp.data());
+            return;
+        }
+        size_t starts[257];
+        distribute(keys, scratch, n, width, 0, starts);
+        std::atomic<size_t> nextBucket(0);
+        auto sortBuckets = [&] {
+            std::vector<unsigned char> tmp(width);
+            for (size_t b; (b = nextBucket++) < 256;) {
+                radixSort(keys + starts[b] * width, scratch + starts[b] * width, starts[b + 1] - starts[b],
+                          width, 1, tmp.data());
+            }
+        };
+        std::vector<std::thread> workers;
+        for (size_t t = 1; t < threads; ++t)
+            workers.emplace_back(sortBuckets);
+        sortBuckets();
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+    // drop adjacent duplicates from the n sorted keys of width bytes at keys, returning how
+    // many are left
+    size_t uniqueKeys(unsigned char *keys, size_t n, size_t width) {
+        if (n == 0)
+            return 0;
+        size_t out = 1;
+        for (size_t i = 1; i < n; ++i) {
+            if (std::memcmp(keys + (out - 1) * width, keys + i * width, width) != 0) {
+                if (out != i)
+                    std::memcpy(keys + out * width, keys + i * width, width);
+                ++out;
+            }
+        }
+        return out;
+    }
+
+    // the hash of a group's HRP, ignoring case, encoding and data part length
+    uint32_t groupHash(const char *hrp, size_t hrpSize, bech32::Encoding encoding, size_t dataLength) {
+        return bech32::caseless::hash(hrp, hrpSize, static_cast<uint32_t>(dataLength * 3 + encoding));
+    }
+
+    // Reads the sorted keys of a run a buffer at a time: from a spilled run, or from keys in
+    // memory
+    class RunReader {
+    public:
+        RunReader(std::FILE *file, uint64_t offset, size_t count, size_t width)
+                : file(file), offset(offset), remaining(count), width(width), pos(0), end(0),
+                  buffer(std::max<size_t>(1, runBufferSize / width) * width), data(buffer.data()) {
+            refill();
+        }
+
+        RunReader(const unsigned char *keys, size_t count, size_t width)
+                : file(nullptr), offset(0), remaining(0), width(width), pos(0), end(count * width), data(keys) {}
+
+        bool done() const { return pos == end; }
+        const unsigned char *current() const { return data + pos; }
+
+        void advance() {
+            pos += width;
+            if (pos == end && file != nullptr)
+                refill();
+        }
+
+    private:
+        void refill() {
+            size_t n = std::min(remaining, buffer.size() / width);
+            pos = 0;
+            end = n * width;
+            if (n == 0)
+                return;
+            if (std::fseek(file, static_cast<long>(offset), SEEK_SET) != 0 ||
+                std::fread(buffer.data(), width, n, file) != n)
+                throw std::runtime_error("could not read a temporary file");
+            offset += end;
+            remaining -= n;
+        }
+
+        std::FILE *file;
+        uint64_t offset;
+        size_t remaining;
+        size_t width;
+        size_t pos;
+        size_t end;
+        std::vector<unsigned char> buffer;
+        const unsigned char *data;
+    };
+
+}
+
+
+namespace bech32 {
+
+    AddressDeduplicator::AddressDeduplicator(const CanonicalizeOptions &options)
+            : options(options), buffered(0), lastGroup(0) {
+        if (this->options.threads == 0)
+            this->options.threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        if (this->options.memoryLimit > maxMemoryLimit)
+            this->options.memoryLimit = static_cast<size_t>(maxMemoryLimit);
+    }
+
+    AddressDeduplicator::~AddressDeduplicator() {
+        for (std::FILE *file : files)
+            std::fclose(file);
+    }
+
+    // add a bech32 string, returning false if it isn't valid
+    bool AddressDeduplicator::add(const std::string &bstring) {
+        DecodedView view = decodeView(bstring, options.lengthLimits);
+        if (view.encoding() == Encoding::Invalid)
+            return false;
+        values.resize(view.size());
+        const char *data = view.hrpData() + view.hrpLength() + 1;
+        simd::mapChars(data, data + view.size(), values.data());
+
+        Encoding encoding = view.encoding();
+        if (options.segwitEncoding && !values.empty() && values[0] <= 16)
+            encoding = values[0] == 0 ? Encoding::Bech32 : Encoding::Bech32m;
+
+        Group &group = groupFor(view.hrpData(), view.hrpLength(), encoding, view.size());
+        size_t size = group.keys.size();
+        group.keys.resize(size + group.keySize);
+        packing::packValues(values.data(), values.size(), &group.keys[size]);
+        buffered += group.keySize;
+        if (buffered >= options.memoryLimit)
+            spill();
+        return true;
+    }
+
+    // the group for the HRP, encoding and data part length, which is added if it is new
+    AddressDeduplicator::Group &AddressDeduplicator::groupFor(const char *hrp, size_t hrpSize, Encoding encoding,
+                                                              size_t dataLength) {
+        // most strings are in the same group as the one before
+        if (lastGroup < groups.size()) {
+            Group &group = groups[lastGroup];
+            if (group.encoding == encoding && group.dataLength == dataLength && caseless::equals(hrp, hrpSize, group.hrp))
+                return group;
+        }
+        uint32_t hash = groupHash(hrp, hrpSize, encoding, dataLength);
+        auto range = groupIds.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            Group &group = groups[it->second];
+            if (group.encoding == encoding && group.dataLength == dataLength && caseless::equals(hrp, hrpSize, group.hrp)) {
+                lastGroup = it->second;
+                return group;
+            }
+        }
+        std::string lower(hrp, hrpSize);
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        // an empty data part still takes a byte, so that its key can be counted
+        Group group = {lower, encoding, dataLength, std::max<size_t>(1, packing::packedBytes(dataLength)),
+                       std::vector<unsigned char>(), std::vector<Run>()};
+        groups.push_back(group);
+        lastGroup = groups.size() - 1;
+        groupIds.emplace(hash, lastGroup);
+        return groups.back();
+    }
+
+    // sort the group's buffered keys and drop duplicates
+    void AddressDeduplicator::sortGroup(Group &group) {
+        size_t n = group.keys.size() / group.keySize;
+        scratch.resize(group.keys.size());
+        sortKeys(group.keys.data(), scratch.data(), n, group.keySize, options.threads);
+        group.keys.resize(uniqueKeys(group.keys.data(), n, group.keySize) * group.keySize);
+    }
+
+    // sort the buffered keys of each group and write them to a temporary file as runs
+    void AddressDeduplicator::spill() {
+        std::FILE *file = std::tmpfile();
+        if (file == nullptr)
+            throw std::runtime_error("could not create a temporary file");
+        files.push_back(file);
+        uint64_t offset = 0;
+        for (Group &group : groups) {
+            if (group.keys.empty())
+                continue;
+            sortGroup(group);
+            size_t count = group.keys.size() / group.keySize;
+            if (std::fwrite(group.keys.data(), group.keySize, count, file) != count)
+                throw std::runtime_error("could not write a temporary file");
+            group.runs.push_back(Run{file, offset, count});
+            offset += group.keys.size();
+            // release the storage, so groups that have spilled don't each keep a chunk
+            std::vector<unsigned char>().swap(group.keys);
+        }
+        if (std::fflush(file) != 0)
+            throw std::runtime_error("could not write a temporary file");
+        buffered = 0;
+        std::vector<unsigned char>().swap(scratch);
+    }
+
+    // call f with each distinct canonical string
+    size_t AddressDeduplicator::finish(const std::function<void(const std::string &)> &f) {
+        std::sort(groups.begin(), groups.end(), [](const Group &a, const Group &b) {
+            if (a.hrp != b.hrp)
+                return a.hrp < b.hrp;
+            if (a.encoding != b.encoding)
+                return a.encoding < b.encoding;
+            return a.dataLength < b.dataLength;
+        });
+
+        size_t ret = 0;
+        std::vector<unsigned char> dp;
+        for (Group &group : groups) {
+            const size_t width = group.keySize;
+            sortGroup(group);
+            std::vector<RunReader> readers;
+            readers.reserve(group.runs.size() + 1);
+            for (const Run &run : group.runs)
+                readers.emplace_back(run.file, run.offset, run.count, width);
+            readers.emplace_back(group.keys.data(), group.keys.size() / width, width);
+
+            // merge the runs, smallest key first
+            auto greater = [&readers, width](size_t a, size_t b) {
+                return std::memcmp(readers[a].current(), readers[b].current(), width) > 0;
+            };
+            std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+            for (size_t i = 0; i < readers.size(); ++i) {
+                if (!readers[i].done())
+                    heap.push(i);
+            }
+            std::vector<unsigned char> last;
+            dp.resize(group.dataLength);
+            while (!heap.empty()) {
+                size_t i = heap.top();
+                heap.pop();
+                const unsigned char *key = readers[i].current();
+                if (last.empty() || std::memcmp(last.data(), key, width) != 0) {
+                    last.assign(key, key + width);
+                    packing::unpackValues(key, group.dataLength, dp.data());
+                    f(group.encoding == Encoding::Bech32m ?
+                      encode(group.hrp, dp, options.lengthLimits) :
+                      encodeUsingOriginalConstant(group.hrp, dp, options.lengthLimits));
+                    ++ret;
+                }
+                readers[i].advance();
+                if (!readers[i].done())
+                    heap.push(i);
+            }
+        }
+
+        groups.clear();
+        groupIds.clear();
+        for (std::FILE *file : files)
+            std::fclose(file);
+        files.clear();
+        buffered = 0;
+        lastGroup = 0;
+        return ret;
+    }
+
+    // write each distinct canonical string read from in to out
+    CanonicalizeStats canonicalizeAddresses(std::istream &in, std::ostream &out, const CanonicalizeOptions &options) {
+        CanonicalizeStats stats = {0, 0, 0};
+        AddressDeduplicator deduplicator(options);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (line.empty())
+                continue;
+            ++stats.lines;
+            if (!deduplicator.add(line))
+                ++stats.invalid;
+        }
+        stats.unique = deduplicator.finish([&out](const std::string &bstring) {
+            out << bstring << '\n';
+        });
+        if (!out)
+            throw std::runtime_error("could not write canonical strings");
+        return stats;
+    }
+
+}
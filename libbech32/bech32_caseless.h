@@ -0,0 +1,41 @@
+#ifndef LIBBECH32_BECH32_CASELESS_H
+#define LIBBECH32_BECH32_CASELESS_H
+
+// Internal: comparing and hashing HRPs ignoring case, for the lookups of expected HRPs, HRP
+// registries, address sets and the canonicalizing sort.
+
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace bech32 {
+
+    namespace caseless {
+
+        // return true if the size chars at first equal the chars of hrp, ignoring case
+        inline bool equals(const char *first, size_t size, const std::string &hrp) {
+            if (size != hrp.size())
+                return false;
+            for (size_t i = 0; i < size; ++i) {
+                if (::tolower(static_cast<unsigned char>(first[i])) != ::tolower(static_cast<unsigned char>(hrp[i])))
+                    return false;
+            }
+            return true;
+        }
+
+        // FNV-1a hash of the size chars at hrp, ignoring case
+        inline uint32_t hash(const char *hrp, size_t size, uint32_t seed) {
+            uint32_t h = 2166136261u ^ seed;
+            for (size_t i = 0; i < size; ++i) {
+                h ^= static_cast<uint32_t>(::tolower(static_cast<unsigned char>(hrp[i])));
+                h *= 16777619u;
+            }
+            return h ^ (h >> 16u);
+        }
+
+    }
+
+}
+
+#endif // LIBBECH32_BECH32_CASELESS_H
@@ -0,0 +1,50 @@
+#ifndef LIBBECH32_BECH32_CHARSET_H
+#define LIBBECH32_BECH32_CHARSET_H
+
+// Internal: the tables mapping data part values to chars and back, shared by the scalar code,
+// the SIMD kernels and base32. They are constexpr, so the kernels' own lookup tables can be
+// checked against them at compile time.
+
+#include "bech32.h"
+
+#include <cstdint>
+
+namespace bech32 {
+
+    namespace tables {
+
+        /** The Bech32 character set for encoding. The index into this array gives the char
+         * each value is mapped to, i.e., 0 -> 'q', 10 -> '2', etc. This comes from the table
+         * in BIP-0173 */
+        constexpr char charset[limits::VALID_CHARSET_SIZE] = {
+                'q', 'p', 'z', 'r', 'y', '9', 'x', '8', 'g', 'f', '2', 't', 'v', 'd', 'w', '0', // indexes 0 - F
+                's', '3', 'j', 'n', '5', '4', 'k', 'h', 'c', 'e', '6', 'm', 'u', 'a', '7', 'l'  // indexes 10 - 1F
+        };
+
+        /** The Bech32 character set for decoding. This comes from the table in BIP-0173
+         *
+         * This will help map both upper and lowercase chars into the proper code (or index
+         * into the above charset). For instance, 'Q' (ascii 81) and 'q' (ascii 113)
+         * are both set to index 0 in this table. Invalid chars are set to -1 */
+        constexpr int REVERSE_CHARSET_SIZE = 128;
+        constexpr int8_t reverse_charset[REVERSE_CHARSET_SIZE] = {
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                15, -1, 10, 17, 21, 20, 26, 30,  7,  5, -1, -1, -1, -1, -1, -1,
+                -1, 29, -1, 24, 13, 25,  9,  8, 23, -1, 18, 22, 31, 27, 19, -1,
+                1,  0,  3, 16, 11, 28, 12, 14,  6,  4,  2, -1, -1, -1, -1, -1,
+                -1, 29, -1, 24, 13, 25,  9,  8, 23, -1, 18, 22, 31, 27, 19, -1,
+                1,  0,  3, 16, 11, 28, 12, 14,  6,  4,  2, -1, -1, -1, -1, -1
+        };
+
+        // the value of any char c, or -1 if it isn't in the charset
+        constexpr int8_t valueOf(unsigned char c) {
+            return c < REVERSE_CHARSET_SIZE ? reverse_charset[c] : static_cast<int8_t>(-1);
+        }
+
+    }
+
+}
+
+#endif // LIBBECH32_BECH32_CHARSET_H
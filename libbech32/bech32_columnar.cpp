@@ -0,0 +1,114 @@
+#include "bech32_columnar.h"
+#include "bech32_packing.h"
+#include "bech32_simd.h"
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+    using bech32::packing::packedBytes;
+    using bech32::packing::packValues;
+
+    // the bytes of string i of the column
+    void rowOf(const bech32::StringColumn &column, size_t i, const char *&first, size_t &size) {
+        int32_t begin = column.offsets[i];
+        int32_t end = column.offsets[i + 1];
+        if (begin < 0 || end < begin)
+            throw std::runtime_error("string column offsets must not decrease");
+        first = column.data + begin;
+        size = static_cast<size_t>(end - begin);
+    }
+
+    // Collects validity bits a byte at a time, clearing the bits past the last string
+    class BitmapWriter {
+    public:
+        explicit BitmapWriter(uint8_t *out) : out(out), bits(0), count(0) {}
+
+        void append(bool bit) {
+            bits |= static_cast<uint8_t>(bit) << (count % 8);
+            if (++count % 8 == 0) {
+                *out++ = bits;
+                bits = 0;
+            }
+        }
+
+        void finish() {
+            if (count % 8 != 0)
+                *out = bits;
+        }
+
+    private:
+        uint8_t *out;
+        uint8_t bits;
+        size_t count;
+    };
+
+}
+
+
+namespace bech32 {
+
+    // decode each string of column into the output columns
+    size_t decodeColumn(const StringColumn & column, const HrpRegistry & registry, const DecodedColumns & out,
+                        const LengthLimits & lengthLimits) {
+        BitmapWriter validity(out.validity);
+        std::vector<unsigned char> values;
+        int32_t dataOffset = 0;
+        if (out.dataOffsets != nullptr)
+            out.dataOffsets[0] = 0;
+        size_t valid = 0;
+
+        for (size_t i = 0; i < column.size; ++i) {
+            const char *first;
+            size_t size;
+            rowOf(column, i, first, size);
+            DecodedView view = decodeView(first, size, lengthLimits);
+            HrpId hrpId = view.encoding() == Encoding::Invalid ? HrpRegistry::unknownHrp
+                                                              : registry.find(view.hrpData(), view.hrpLength());
+            bool isValid = hrpId != HrpRegistry::unknownHrp;
+            valid += isValid;
+            validity.append(isValid);
+            if (out.encodings != nullptr)
+                out.encodings[i] = static_cast<uint8_t>(isValid ? view.encoding() : Encoding::Invalid);
+            if (out.hrpIds != nullptr)
+                out.hrpIds[i] = hrpId;
+            if (out.dataLengths != nullptr)
+                out.dataLengths[i] = isValid ? static_cast<int32_t>(view.size()) : 0;
+            if (out.dataOffsets != nullptr) {
+                if (isValid) {
+                    const char *data = view.hrpData() + view.hrpLength() + 1;
+                    if (values.size() < view.size())
+                        values.resize(view.size());
+                    simd::mapChars(data, data + view.size(), values.data());
+                    packValues(values.data(), view.size(), out.data + dataOffset);
+                    dataOffset += static_cast<int32_t>(packedBytes(view.size()));
+                }
+                out.dataOffsets[i + 1] = dataOffset;
+            }
+        }
+        validity.finish();
+        return valid;
+    }
+
+    // check each string of column, writing the validity bitmap and encodings
+    size_t validateColumn(const StringColumn & column, uint8_t * validity, uint8_t * encodings,
+                          const LengthLimits & lengthLimits) {
+        BitmapWriter bitmap(validity);
+        size_t valid = 0;
+        for (size_t i = 0; i < column.size; ++i) {
+            const char *first;
+            size_t size;
+            rowOf(column, i, first, size);
+            Encoding encoding = decodeView(first, size, lengthLimits).encoding();
+            bool isValid = encoding != Encoding::Invalid;
+            valid += isValid;
+            bitmap.append(isValid);
+            if (encodings != nullptr)
+                encodings[i] = static_cast<uint8_t>(encoding);
+        }
+        bitmap.finish();
+        return valid;
+    }
+
+}
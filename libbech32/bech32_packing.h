@@ -0,0 +1,62 @@
+#ifndef LIBBECH32_BECH32_PACKING_H
+#define LIBBECH32_BECH32_PACKING_H
+
+// Internal: packing data part values at 5 bits each, most significant bit first, the same
+// layout as PackedData. Used for the fixed-width keys of address tables, address sets and
+// the canonicalizing sort.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bech32 {
+
+    namespace packing {
+
+        // number of bytes holding n packed values
+        inline size_t packedBytes(size_t n) {
+            return (5 * n + 7) / 8;
+        }
+
+        // Pack the n values at values (each less than 32) into packedBytes(n) bytes at out,
+        // padding the last byte with zeros
+        inline void packValues(const unsigned char *values, size_t n, unsigned char *out) {
+            for (; n >= 8; values += 8, n -= 8, out += 5) {
+                uint64_t bits = 0;
+                for (unsigned i = 0; i < 8; ++i)
+                    bits = bits << 5u | values[i];
+                for (unsigned i = 0; i < 5; ++i)
+                    out[i] = static_cast<unsigned char>(bits >> (32 - 8 * i));
+            }
+            if (n != 0) {
+                uint64_t bits = 0;
+                for (size_t i = 0; i < n; ++i)
+                    bits = bits << 5u | values[i];
+                bits <<= 5 * (8 - n);
+                for (size_t i = 0; i < packedBytes(n); ++i)
+                    out[i] = static_cast<unsigned char>(bits >> (32 - 8 * i));
+            }
+        }
+
+        // unpack n values from the packedBytes(n) bytes at packed to out
+        inline void unpackValues(const unsigned char *packed, size_t n, unsigned char *out) {
+            for (; n >= 8; packed += 5, n -= 8, out += 8) {
+                uint64_t bits = 0;
+                for (unsigned i = 0; i < 5; ++i)
+                    bits = bits << 8u | packed[i];
+                for (unsigned i = 0; i < 8; ++i)
+                    out[i] = static_cast<unsigned char>(bits >> (35 - 5 * i) & 31u);
+            }
+            if (n != 0) {
+                uint64_t bits = 0;
+                for (size_t i = 0; i < 5; ++i)
+                    bits = bits << 8u | (i < packedBytes(n) ? packed[i] : 0u);
+                for (size_t i = 0; i < n; ++i)
+                    out[i] = static_cast<unsigned char>(bits >> (35 - 5 * i) & 31u);
+            }
+        }
+
+    }
+
+}
+
+#endif // LIBBECH32_BECH32_PACKING_H
@@ -0,0 +1,243 @@
+#include "bech32_set.h"
+#include "bech32_caseless.h"
+#include "bech32_packing.h"
+#include "bech32_simd.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+    using bech32::packing::packedBytes;
+    using bech32::packing::packValues;
+
+    // hash of a key, 8 bytes at a time
+    uint64_t hashKey(const unsigned char *key, size_t size) {
+        uint64_t h = 0x9e3779b97f4a7c15u ^ size;
+        for (; size >= 8; key += 8, size -= 8) {
+            uint64_t w;
+            std::memcpy(&w, key, 8);
+            h = (h ^ w) * 0xff51afd7ed558ccdu;
+            h ^= h >> 32u;
+        }
+        if (size != 0) {
+            uint64_t w = 0;
+            std::memcpy(&w, key, size);
+            h = (h ^ w) * 0xff51afd7ed558ccdu;
+        }
+        h ^= h >> 33u;
+        h *= 0xc4ceb9fe1a85ec53u;
+        h ^= h >> 33u;
+        return h;
+    }
+
+    // the slot a hash starts probing from, in a table of capacity slots
+    size_t homeSlot(uint64_t hash, size_t capacity) {
+        // the high bits of the hash scaled to the capacity, which needn't be a power of 2
+        return static_cast<size_t>((hash >> 32u) * capacity >> 32u);
+    }
+
+    // the nonzero tag of a hash
+    uint8_t tagOf(uint64_t hash) {
+        return static_cast<uint8_t>((hash & 0x7fu) + 1);
+    }
+
+    // a buffer for a key, on the stack for data parts of standard length
+    class KeyBuffer {
+    public:
+        explicit KeyBuffer(size_t dataLength) {
+            if (dataLength > sizeof(values)) {
+                longValues.resize(dataLength);
+                longKey.resize(packedBytes(dataLength));
+            }
+            valuesData = longValues.empty() ? values : longValues.data();
+            keyData = longKey.empty() ? key : longKey.data();
+            // an empty data part packs to no bytes, and its key is a single zero byte
+            key[0] = 0;
+        }
+
+        unsigned char *valuesBuffer() { return valuesData; }
+        unsigned char *keyBuffer() { return keyData; }
+
+    private:
+        unsigned char values[bech32::limits::MAX_BECH32_LENGTH];
+        unsigned char key[(5 * bech32::limits::MAX_BECH32_LENGTH + 7) / 8];
+        std::vector<unsigned char> longValues;
+        std::vector<unsigned char> longKey;
+        unsigned char *valuesData;
+        unsigned char *keyData;
+    };
+
+}
+
+
+namespace bech32 {
+
+    // add a payload, returning true if it wasn't already in the set
+    bool AddressSet::insert(const DecodedResult &decoded) {
+        if (decoded.encoding == Encoding::Invalid)
+            throw std::runtime_error("an address set can only hold valid payloads");
+        if (std::any_of(decoded.dp.begin(), decoded.dp.end(), [](unsigned char v) { return v > 31; }))
+            throw std::runtime_error("data value is out of range");
+        Group &group = groupFor(decoded.hrp, decoded.encoding, decoded.dp.size());
+        std::vector<unsigned char> key(group.keySize);
+        packValues(decoded.dp.data(), decoded.dp.size(), key.data());
+        bool inserted = groupInsert(group, key.data());
+        count += inserted;
+        return inserted;
+    }
+
+    // decode a bech32 string and add its payload
+    bool AddressSet::insert(const std::string &bstring, const LengthLimits &lengthLimits) {
+        DecodedView view = decodeView(bstring, lengthLimits);
+        if (view.encoding() == Encoding::Invalid)
+            return false;
+        std::string hrp(view.hrpData(), view.hrpLength());
+        Group &group = groupFor(hrp, view.encoding(), view.size());
+        KeyBuffer buffer(view.size());
+        const char *data = view.hrpData() + view.hrpLength() + 1;
+        simd::mapChars(data, data + view.size(), buffer.valuesBuffer());
+        packValues(buffer.valuesBuffer(), view.size(), buffer.keyBuffer());
+        bool inserted = groupInsert(group, buffer.keyBuffer());
+        count += inserted;
+        return inserted;
+    }
+
+    // return true if the set holds the payload
+    bool AddressSet::contains(const DecodedResult &decoded) const {
+        const Group *group = findGroup(findHrp(decoded.hrp.data(), decoded.hrp.size()),
+                                       decoded.encoding, decoded.dp.size());
+        if (group == nullptr)
+            return false;
+        if (std::any_of(decoded.dp.begin(), decoded.dp.end(), [](unsigned char v) { return v > 31; }))
+            return false;
+        KeyBuffer buffer(decoded.dp.size());
+        packValues(decoded.dp.data(), decoded.dp.size(), buffer.keyBuffer());
+        return groupContains(*group, buffer.keyBuffer());
+    }
+
+    // return true if bstring is valid and the set holds its payload
+    bool AddressSet::contains(const std::string &bstring, const LengthLimits &lengthLimits) const {
+        DecodedView view = decodeView(bstring, lengthLimits);
+        const Group *group = findGroup(findHrp(view.hrpData(), view.hrpLength()), view.encoding(), view.size());
+        if (group == nullptr)
+            return false;
+        KeyBuffer buffer(view.size());
+        const char *data = view.hrpData() + view.hrpLength() + 1;
+        simd::mapChars(data, data + view.size(), buffer.valuesBuffer());
+        packValues(buffer.valuesBuffer(), view.size(), buffer.keyBuffer());
+        return groupContains(*group, buffer.keyBuffer());
+    }
+
+    // number of bytes held by the set's tables
+    size_t AddressSet::memoryUsage() const {
+        size_t ret = 0;
+        for (const Group &group : groups)
+            ret += group.tags.capacity() + group.keys.capacity();
+        return ret;
+    }
+
+    // the id of the HRP equal, ignoring case, to the size chars at hrp, or unknownHrp
+    HrpId AddressSet::findHrp(const char *hrp, size_t size) const {
+        auto range = hrpIds.equal_range(caseless::hash(hrp, size, 0));
+        for (auto it = range.first; it != range.second; ++it) {
+            if (caseless::equals(hrp, size, hrps[it->second]))
+                return it->second;
+        }
+        return HrpRegistry::unknownHrp;
+    }
+
+    // the index of the group for the HRP id, encoding and data part length, or the number of
+    // groups if there is none
+    size_t AddressSet::groupIndex(HrpId hrpId, Encoding encoding, size_t dataLength) const {
+        auto it = groupIds.find(groupKey(hrpId, encoding, dataLength));
+        return it == groupIds.end() ? groups.size() : it->second;
+    }
+
+    // the key of a group in groupIds; data parts are far shorter than 2^40 values
+    uint64_t AddressSet::groupKey(HrpId hrpId, Encoding encoding, size_t dataLength) {
+        return static_cast<uint64_t>(dataLength) << 24u | static_cast<uint64_t>(encoding) << 16u | hrpId;
+    }
+
+    // the group for the HRP id, encoding and data part length, or nullptr if there is none
+    const AddressSet::Group *AddressSet::findGroup(HrpId hrpId, Encoding encoding, size_t dataLength) const {
+        if (hrpId == HrpRegistry::unknownHrp || encoding == Encoding::Invalid)
+            return nullptr;
+        size_t i = groupIndex(hrpId, encoding, dataLength);
+        return i == groups.size() ? nullptr : &groups[i];
+    }
+
+    // the group for the HRP, encoding and data part length, which is added if it is new
+    AddressSet::Group &AddressSet::groupFor(const std::string &hrp, Encoding encoding, size_t dataLength) {
+        HrpId hrpId = findHrp(hrp.data(), hrp.size());
+        if (hrpId == HrpRegistry::unknownHrp) {
+            if (hrp.empty())
+                throw std::runtime_error("HRP must be at least one character");
+            if (hrps.size() + 1 >= HrpRegistry::unknownHrp)
+                throw std::runtime_error("too many HRPs for an address set");
+            std::string lower = hrp;
+            std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+            hrps.push_back(lower);
+            hrpId = static_cast<HrpId>(hrps.size() - 1);
+            hrpIds.emplace(caseless::hash(lower.data(), lower.size(), 0), hrpId);
+        }
+        size_t i = groupIndex(hrpId, encoding, dataLength);
+        if (i == groups.size()) {
+            // an empty data part still takes a byte, so that its key can be stored
+            Group group = {hrpId, encoding, dataLength, std::max<size_t>(1, packedBytes(dataLength)), 0,
+                           std::vector<uint8_t>(), std::vector<unsigned char>()};
+            groups.push_back(group);
+            groupIds.emplace(groupKey(hrpId, encoding, dataLength), i);
+        }
+        return groups[i];
+    }
+
+    // return true if the group holds key
+    bool AddressSet::groupContains(const Group &group, const unsigned char *key) {
+        size_t capacity = group.tags.size();
+        if (capacity == 0)
+            return false;
+        uint64_t hash = hashKey(key, group.keySize);
+        uint8_t tag = tagOf(hash);
+        for (size_t i = homeSlot(hash, capacity); group.tags[i] != 0; i = i + 1 == capacity ? 0 : i + 1) {
+            if (group.tags[i] == tag && std::memcmp(&group.keys[i * group.keySize], key, group.keySize) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    // add key to the group, returning true if it wasn't already there
+    bool AddressSet::groupInsert(Group &group, const unsigned char *key) {
+        if (groupContains(group, key))
+            return false;
+        // keep at least a fifth of the slots empty
+        if (5 * (group.used + 1) > 4 * group.tags.size())
+            grow(group);
+        size_t capacity = group.tags.size();
+        uint64_t hash = hashKey(key, group.keySize);
+        size_t i = homeSlot(hash, capacity);
+        while (group.tags[i] != 0)
+            i = i + 1 == capacity ? 0 : i + 1;
+        group.tags[i] = tagOf(hash);
+        std::memcpy(&group.keys[i * group.keySize], key, group.keySize);
+        ++group.used;
+        return true;
+    }
+
+    // grow the group's table by half, rehashing its keys
+    void AddressSet::grow(Group &group) {
+        Group old = {group.hrpId, group.encoding, group.dataLength, group.keySize, 0,
+                     std::vector<uint8_t>(), std::vector<unsigned char>()};
+        std::swap(old.tags, group.tags);
+        std::swap(old.keys, group.keys);
+        size_t capacity = std::max<size_t>(16, old.tags.size() + old.tags.size() / 2);
+        group.tags.assign(capacity, 0);
+        group.keys.assign(capacity * group.keySize, 0);
+        group.used = 0;
+        for (size_t i = 0; i < old.tags.size(); ++i) {
+            if (old.tags[i] != 0)
+                groupInsert(group, &old.keys[i * group.keySize]);
+        }
+    }
+
+}
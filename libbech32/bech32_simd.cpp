@@ -0,0 +1,364 @@
+#include "bech32_simd.h"
+#include "bech32.h"
+#include "bech32_charset.h"
+#include "bech32_packing.h"
+
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+
+#ifdef LIBBECH32_HAVE_SSSE3
+#include <tmmintrin.h>
+#endif
+
+namespace {
+
+    using bech32::tables::charset;
+
+    // the chars kept by stripUnknownChars(): the charset, in either case, and the separator
+    const std::array<bool, 256> & keptChars() {
+        static const std::array<bool, 256> kept = [] {
+            std::array<bool, 256> ret = {};
+            for (char c : charset) {
+                ret[static_cast<unsigned char>(c)] = true;
+                ret[static_cast<unsigned char>(::toupper(c))] = true;
+            }
+            ret[static_cast<unsigned char>(bech32::separator)] = true;
+            return ret;
+        }();
+        return kept;
+    }
+
+#ifdef LIBBECH32_HAVE_SSSE3
+
+    // For each 8 bit mask of kept bytes, the pshufb indexes that move those bytes to the
+    // front of an 8 byte half, and the number of kept bytes (popcnt isn't available on every
+    // CPU with SSSE3)
+    struct CompactShuffles {
+        std::array<std::array<uint8_t, 8>, 256> indexes;
+        std::array<uint8_t, 256> counts;
+    };
+
+    const CompactShuffles & compactShuffles() {
+        static const CompactShuffles shuffles = [] {
+            CompactShuffles ret;
+            for (unsigned mask = 0; mask < 256; ++mask) {
+                unsigned n = 0;
+                for (unsigned i = 0; i < 8; ++i) {
+                    if (mask & (1u << i))
+                        ret.indexes[mask][n++] = static_cast<uint8_t>(i);
+                }
+                ret.counts[mask] = static_cast<uint8_t>(n);
+                for (; n < 8; ++n)
+                    ret.indexes[mask][n] = 0x80;
+            }
+            return ret;
+        }();
+        return shuffles;
+    }
+
+    // Chars are classified 16 at a time by looking each up by its low and high nibble in two
+    // tables of class bits, and are in a class if the results share a bit:
+    //   1: digits        (high nibble 3, low nibble 0-9)
+    //   2: letters A-N   (high nibble 4 or 6, low nibble 1-14, but not B or I)
+    //   4: letters P-Z   (high nibble 5 or 7, low nibble 0-10)
+    // which leaves out O and all non-alphanumeric chars. The kept chars also have the
+    // separator (digit 1), which the charset doesn't.
+    constexpr int8_t keptLowClasses[16] = {5, 7, 5, 7, 7, 7, 7, 7, 7, 5, 6, 2, 2, 2, 2, 0};
+    constexpr int8_t charsetLowClasses[16] = {5, 6, 5, 7, 7, 7, 7, 7, 7, 5, 6, 2, 2, 2, 2, 0};
+    constexpr int8_t highClasses[16] = {0, 0, 0, 1, 2, 4, 2, 4, 0, 0, 0, 0, 0, 0, 0, 0};
+
+    // return true if the class tables put exactly the charset chars, and the separator if
+    // withSeparator, in a class, checking chars from c on
+    constexpr bool classifiesCharset(const int8_t *low, bool withSeparator, unsigned c = 0) {
+        return c == 256 ||
+               (((low[c & 15u] & highClasses[c >> 4u]) != 0) ==
+                (bech32::tables::valueOf(static_cast<unsigned char>(c)) != -1 || (withSeparator && c == bech32::separator)) &&
+                classifiesCharset(low, withSeparator, c + 1));
+    }
+
+    static_assert(classifiesCharset(keptLowClasses, true), "keptLowClasses doesn't match the charset");
+    static_assert(classifiesCharset(charsetLowClasses, false), "charsetLowClasses doesn't match the charset");
+
+    // The values of the charset chars by low nibble: for the digits, and for the lower case
+    // letters with high nibble 6 and 7. Chars not in the charset have 0
+    constexpr int8_t digitValues[16] = {15, 0, 10, 17, 21, 20, 26, 30, 7, 5, 0, 0, 0, 0, 0, 0};
+    constexpr int8_t lowerAValues[16] = {0, 29, 0, 24, 13, 25, 9, 8, 23, 0, 18, 22, 31, 27, 19, 0};
+    constexpr int8_t lowerPValues[16] = {1, 0, 3, 16, 11, 28, 12, 14, 6, 4, 2, 0, 0, 0, 0, 0};
+
+    // return true if values holds the values of the chars with the given high nibble, checking
+    // low nibbles from low on
+    constexpr bool matchesCharset(const int8_t *values, unsigned high, unsigned low = 0) {
+        return low == 16 ||
+               (values[low] == (bech32::tables::valueOf(static_cast<unsigned char>(high << 4u | low)) == -1 ? 0 :
+                                bech32::tables::valueOf(static_cast<unsigned char>(high << 4u | low))) &&
+                matchesCharset(values, high, low + 1));
+    }
+
+    static_assert(matchesCharset(digitValues, 3), "digitValues doesn't match the charset");
+    static_assert(matchesCharset(lowerAValues, 6), "lowerAValues doesn't match the charset");
+    static_assert(matchesCharset(lowerPValues, 7), "lowerPValues doesn't match the charset");
+
+    // return a bit mask of the chars of v that are in a class of the given low nibble table
+    __attribute__((target("ssse3")))
+    inline unsigned classMask(__m128i v, const int8_t *lowClasses) {
+        const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lowClasses));
+        const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(highClasses));
+        const __m128i nibble = _mm_set1_epi8(0x0f);
+        __m128i lows = _mm_shuffle_epi8(low, _mm_and_si128(v, nibble));
+        __m128i highs = _mm_shuffle_epi8(high, _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+        __m128i dropped = _mm_cmpeq_epi8(_mm_and_si128(lows, highs), _mm_setzero_si128());
+        return ~static_cast<unsigned>(_mm_movemask_epi8(dropped)) & 0xffffu;
+    }
+
+    // return a bit mask of the chars of v that stripUnknownChars() keeps
+    __attribute__((target("ssse3")))
+    inline unsigned keptMask(__m128i v) {
+        return classMask(v, keptLowClasses);
+    }
+
+    // As keptMask(), but for the charset alone: the separator is not kept
+    __attribute__((target("ssse3")))
+    inline unsigned charsetMask(__m128i v) {
+        return classMask(v, charsetLowClasses);
+    }
+
+#endif
+
+}
+
+namespace bech32 {
+
+    namespace simd {
+
+        bool hasSsse3() {
+#ifdef LIBBECH32_HAVE_SSSE3
+            static const bool supported = __builtin_cpu_supports("ssse3") != 0;
+            return supported;
+#else
+            return false;
+#endif
+        }
+
+        char * stripUnknownCharsScalar(const char * first, const char * last, char * out) {
+            const std::array<bool, 256> &kept = keptChars();
+            for (; first != last; ++first) {
+                char c = *first;
+                *out = c;
+                out += kept[static_cast<unsigned char>(c)];
+            }
+            return out;
+        }
+
+#ifdef LIBBECH32_HAVE_SSSE3
+
+        // Stream compaction, 16 chars at a time: each 8 byte half is packed with pshufb using
+        // the indexes for its mask, then stored in full; the bytes past the kept ones are
+        // overwritten by the next store. Since all of a block is loaded before its stores, and
+        // the stores never pass the end of the block, out may equal first.
+        __attribute__((target("ssse3")))
+        char * stripUnknownCharsSsse3(const char * first, const char * last, char * out) {
+            const CompactShuffles &shuffles = compactShuffles();
+            for (; last - first >= 16; first += 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+                unsigned mask = keptMask(v);
+                if (mask == 0xffffu) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), v);
+                    out += 16;
+                    continue;
+                }
+                unsigned lowMask = mask & 0xffu;
+                unsigned highMask = mask >> 8u;
+                __m128i lowShuffle = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(shuffles.indexes[lowMask].data()));
+                __m128i highShuffle = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(shuffles.indexes[highMask].data()));
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(out), _mm_shuffle_epi8(v, lowShuffle));
+                out += shuffles.counts[lowMask];
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(out), _mm_shuffle_epi8(_mm_srli_si128(v, 8), highShuffle));
+                out += shuffles.counts[highMask];
+            }
+            return stripUnknownCharsScalar(first, last, out);
+        }
+
+#endif
+
+        char * stripUnknownChars(const char * first, const char * last, char * out) {
+#ifdef LIBBECH32_HAVE_SSSE3
+            if (hasSsse3())
+                return stripUnknownCharsSsse3(first, last, out);
+#endif
+            return stripUnknownCharsScalar(first, last, out);
+        }
+
+        const char * mapCharsScalar(const char * first, const char * last, unsigned char * out) {
+            for (; first != last; ++first, ++out) {
+                int8_t d = tables::valueOf(static_cast<unsigned char>(*first));
+                if (d == -1)
+                    break;
+                *out = static_cast<unsigned char>(d);
+            }
+            return first;
+        }
+
+#ifdef LIBBECH32_HAVE_SSSE3
+
+        // 16 chars at a time: once a block is known to be all charset chars, upper case letters
+        // are folded to lower case by setting bit 5 (which leaves digits as they are), and the
+        // values are looked up by low nibble in a table for each of the three high nibbles
+        // left. A block with any other char is left to the scalar version, which finds it.
+        __attribute__((target("ssse3")))
+        const char * mapCharsSsse3(const char * first, const char * last, unsigned char * out) {
+            const __m128i digits = _mm_loadu_si128(reinterpret_cast<const __m128i *>(digitValues));
+            const __m128i lowerA = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lowerAValues));
+            const __m128i lowerP = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lowerPValues));
+            const __m128i nibble = _mm_set1_epi8(0x0f);
+            const __m128i caseBit = _mm_set1_epi8(0x20);
+            for (; last - first >= 16; first += 16, out += 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+                if (charsetMask(v) != 0xffffu)
+                    break;
+                __m128i folded = _mm_or_si128(v, caseBit);
+                __m128i low = _mm_and_si128(folded, nibble);
+                __m128i high = _mm_and_si128(_mm_srli_epi16(folded, 4), nibble);
+                __m128i digitsOut = _mm_and_si128(_mm_shuffle_epi8(digits, low),
+                                                  _mm_cmpeq_epi8(high, _mm_set1_epi8(3)));
+                __m128i lowerAOut = _mm_and_si128(_mm_shuffle_epi8(lowerA, low),
+                                                  _mm_cmpeq_epi8(high, _mm_set1_epi8(6)));
+                __m128i lowerPOut = _mm_and_si128(_mm_shuffle_epi8(lowerP, low),
+                                                  _mm_cmpeq_epi8(high, _mm_set1_epi8(7)));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_or_si128(digitsOut, _mm_or_si128(lowerAOut, lowerPOut)));
+            }
+            return mapCharsScalar(first, last, out);
+        }
+
+#endif
+
+        const char * mapChars(const char * first, const char * last, unsigned char * out) {
+#ifdef LIBBECH32_HAVE_SSSE3
+            if (hasSsse3())
+                return mapCharsSsse3(first, last, out);
+#endif
+            return mapCharsScalar(first, last, out);
+        }
+
+        const unsigned char * mapValuesScalar(const unsigned char * first, const unsigned char * last, char * out) {
+            for (; first != last; ++first, ++out) {
+                if (*first > 31)
+                    break;
+                *out = charset[*first];
+            }
+            return first;
+        }
+
+#ifdef LIBBECH32_HAVE_SSSE3
+
+        // 16 values at a time: each value is looked up by its low 4 bits in the tables for the
+        // first and second halves of the charset, and bit 4 selects between the two
+        __attribute__((target("ssse3")))
+        const unsigned char * mapValuesSsse3(const unsigned char * first, const unsigned char * last, char * out) {
+            const __m128i firstHalf = _mm_loadu_si128(reinterpret_cast<const __m128i *>(charset));
+            const __m128i secondHalf = _mm_loadu_si128(reinterpret_cast<const __m128i *>(charset + 16));
+            const __m128i maxValue = _mm_set1_epi8(31);
+            const __m128i nibble = _mm_set1_epi8(0x0f);
+            const __m128i halfBit = _mm_set1_epi8(0x10);
+            for (; last - first >= 16; first += 16, out += 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(v, maxValue), maxValue)) != 0xffff)
+                    break;
+                __m128i low = _mm_and_si128(v, nibble);
+                __m128i second = _mm_cmpeq_epi8(_mm_and_si128(v, halfBit), halfBit);
+                __m128i chars = _mm_or_si128(_mm_andnot_si128(second, _mm_shuffle_epi8(firstHalf, low)),
+                                             _mm_and_si128(second, _mm_shuffle_epi8(secondHalf, low)));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out), chars);
+            }
+            return mapValuesScalar(first, last, out);
+        }
+
+#endif
+
+        const unsigned char * mapValues(const unsigned char * first, const unsigned char * last, char * out) {
+#ifdef LIBBECH32_HAVE_SSSE3
+            if (hasSsse3())
+                return mapValuesSsse3(first, last, out);
+#endif
+            return mapValuesScalar(first, last, out);
+        }
+
+        void unpackGroupsScalar(const unsigned char * packed, size_t groups, unsigned char * values) {
+            packing::unpackValues(packed, 8 * groups, values);
+        }
+
+#ifdef LIBBECH32_HAVE_SSSE3
+
+        // 2 groups (10 bytes, 16 values) at a time: each value's 16-bit lane gets the two bytes
+        // that hold its bits, big-endian, and is shifted right by a lane's own amount by a
+        // high multiply with a power of 2. 16 bytes are read, so the last few groups are left
+        // to the scalar version
+        __attribute__((target("ssse3")))
+        void unpackGroupsSsse3(const unsigned char * packed, size_t groups, unsigned char * values) {
+            const __m128i firstBytes = _mm_setr_epi8(1, 0, 1, 0, 2, 1, 2, 1, 3, 2, 4, 3, 4, 3, 5, 4);
+            const __m128i secondBytes = _mm_setr_epi8(6, 5, 6, 5, 7, 6, 7, 6, 8, 7, 9, 8, 9, 8, 10, 9);
+            // 2^(16 - shift) for shifts 11, 6, 9, 4, 7, 10, 5 and 8
+            const __m128i multipliers = _mm_setr_epi16(1 << 5, 1 << 10, 1 << 7, 1 << 12, 1 << 9, 1 << 6, 1 << 11, 1 << 8);
+            const __m128i valueMask = _mm_set1_epi16(31);
+            for (; groups >= 4; groups -= 2, packed += 10, values += 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(packed));
+                __m128i first = _mm_and_si128(_mm_mulhi_epu16(_mm_shuffle_epi8(v, firstBytes), multipliers), valueMask);
+                __m128i second = _mm_and_si128(_mm_mulhi_epu16(_mm_shuffle_epi8(v, secondBytes), multipliers), valueMask);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(values), _mm_packus_epi16(first, second));
+            }
+            unpackGroupsScalar(packed, groups, values);
+        }
+
+#endif
+
+        void unpackGroups(const unsigned char * packed, size_t groups, unsigned char * values) {
+#ifdef LIBBECH32_HAVE_SSSE3
+            if (hasSsse3())
+                return unpackGroupsSsse3(packed, groups, values);
+#endif
+            unpackGroupsScalar(packed, groups, values);
+        }
+
+        void packGroupsScalar(const unsigned char * values, size_t groups, unsigned char * packed) {
+            packing::packValues(values, 8 * groups, packed);
+        }
+
+#ifdef LIBBECH32_HAVE_SSSE3
+
+        // 2 groups (16 values, 10 bytes) at a time: pairs of values are merged into 10 bits by
+        // a multiply-add, pairs of those into 20 bits by another, and pairs of those into the
+        // 40 bits of each group by shifts, whose bytes are then shuffled into big-endian order
+        __attribute__((target("ssse3")))
+        void packGroupsSsse3(const unsigned char * values, size_t groups, unsigned char * packed) {
+            const __m128i pairWeights = _mm_set1_epi16(0x0120);
+            const __m128i quadWeights = _mm_set1_epi32(0x00010400);
+            const __m128i lowHalf = _mm_set_epi32(0, -1, 0, -1);
+            const __m128i bigEndian = _mm_setr_epi8(4, 3, 2, 1, 0, 12, 11, 10, 9, 8, -1, -1, -1, -1, -1, -1);
+            for (; groups >= 2; groups -= 2, values += 16, packed += 10) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values));
+                __m128i tens = _mm_maddubs_epi16(v, pairWeights);
+                __m128i twenties = _mm_madd_epi16(tens, quadWeights);
+                __m128i forties = _mm_or_si128(_mm_slli_epi64(_mm_and_si128(twenties, lowHalf), 20),
+                                               _mm_srli_epi64(twenties, 32));
+                __m128i bytes = _mm_shuffle_epi8(forties, bigEndian);
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(packed), bytes);
+                auto lastTwo = static_cast<uint16_t>(_mm_extract_epi16(bytes, 4));
+                std::memcpy(packed + 8, &lastTwo, 2);
+            }
+            packGroupsScalar(values, groups, packed);
+        }
+
+#endif
+
+        void packGroups(const unsigned char * values, size_t groups, unsigned char * packed) {
+#ifdef LIBBECH32_HAVE_SSSE3
+            if (hasSsse3())
+                return packGroupsSsse3(values, groups, packed);
+#endif
+            packGroupsScalar(values, groups, packed);
+        }
+
+    }
+
+}
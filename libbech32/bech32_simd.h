@@ -0,0 +1,77 @@
+#ifndef LIBBECH32_BECH32_SIMD_H
+#define LIBBECH32_BECH32_SIMD_H
+
+// Internal: byte-at-a-time loops over bech32 strings, each with a portable scalar version and,
+// on x86 with GCC or Clang, an SSSE3 version selected at runtime.
+
+#include <cstddef>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define LIBBECH32_HAVE_SSSE3 1
+#endif
+
+namespace bech32 {
+
+    namespace simd {
+
+        // return true if the SSSE3 versions can run on this CPU
+        bool hasSsse3();
+
+        // Copy the chars of [first, last) that stripUnknownChars() keeps (chars in the charset,
+        // in either case, and the separator) to out, returning the end of the output. out may
+        // equal first, to strip in place.
+        char * stripUnknownCharsScalar(const char * first, const char * last, char * out);
+#ifdef LIBBECH32_HAVE_SSSE3
+        char * stripUnknownCharsSsse3(const char * first, const char * last, char * out);
+#endif
+
+        // as above, using the fastest version for this CPU
+        char * stripUnknownChars(const char * first, const char * last, char * out);
+
+        // Map the chars of [first, last), in either case, to their 5-bit values in out,
+        // returning a pointer to the first char that is not in the charset, or last if all of
+        // them are. out is written up to that char, and may equal first (as unsigned char *).
+        const char * mapCharsScalar(const char * first, const char * last, unsigned char * out);
+#ifdef LIBBECH32_HAVE_SSSE3
+        const char * mapCharsSsse3(const char * first, const char * last, unsigned char * out);
+#endif
+
+        // as above, using the fastest version for this CPU
+        const char * mapChars(const char * first, const char * last, unsigned char * out);
+
+        // Map the 5-bit values of [first, last) to their (lowercase) chars in out, returning a
+        // pointer to the first value that is out of range, or last if none is. out is written
+        // up to that value.
+        const unsigned char * mapValuesScalar(const unsigned char * first, const unsigned char * last, char * out);
+#ifdef LIBBECH32_HAVE_SSSE3
+        const unsigned char * mapValuesSsse3(const unsigned char * first, const unsigned char * last, char * out);
+#endif
+
+        // as above, using the fastest version for this CPU
+        const unsigned char * mapValues(const unsigned char * first, const unsigned char * last, char * out);
+
+        // Regroup whole groups of 5 bytes at packed into 8 5-bit values each, most significant
+        // bit first (the layout of PackedData), writing 8 * groups values to values.
+        void unpackGroupsScalar(const unsigned char * packed, size_t groups, unsigned char * values);
+#ifdef LIBBECH32_HAVE_SSSE3
+        void unpackGroupsSsse3(const unsigned char * packed, size_t groups, unsigned char * values);
+#endif
+
+        // as above, using the fastest version for this CPU
+        void unpackGroups(const unsigned char * packed, size_t groups, unsigned char * values);
+
+        // The reverse: regroup whole groups of 8 values (each less than 32) at values into 5
+        // bytes each, writing 5 * groups bytes to packed.
+        void packGroupsScalar(const unsigned char * values, size_t groups, unsigned char * packed);
+#ifdef LIBBECH32_HAVE_SSSE3
+        void packGroupsSsse3(const unsigned char * values, size_t groups, unsigned char * packed);
+#endif
+
+        // as above, using the fastest version for this CPU
+        void packGroups(const unsigned char * values, size_t groups, unsigned char * packed);
+
+    }
+
+}
+
+#endif // LIBBECH32_BECH32_SIMD_H
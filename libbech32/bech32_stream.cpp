@@ -0,0 +1,135 @@
+#include "bech32_stream.h"
+#include "bech32_checksum.h"
+#include "bech32_simd.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+    using namespace bech32::limits;
+
+    // return true if the chars of the string are within the allowed range and aren't of
+    // mixed case
+    bool charsAreWellFormed(const std::string &bstring) {
+        bool atLeastOneUpper = false;
+        bool atLeastOneLower = false;
+        for (char c : bstring) {
+            if (c < MIN_BECH32_CHAR_VALUE || c > MAX_BECH32_CHAR_VALUE)
+                return false;
+            atLeastOneUpper |= c >= 'A' && c <= 'Z';
+            atLeastOneLower |= c >= 'a' && c <= 'z';
+        }
+        return !(atLeastOneUpper && atLeastOneLower);
+    }
+
+}
+
+
+namespace bech32 {
+
+    StreamDecoder::StreamDecoder(const Callback & callback, const LengthLimits & lengthLimits,
+                                 const std::string & delimiters)
+            : callback(callback), lengthLimits(lengthLimits), separatorPos(std::string::npos), dataChk(0),
+              badData(false), tooLong(false), completed(0) {
+        std::memset(isDelimiter, 0, sizeof(isDelimiter));
+        for (char c : delimiters)
+            isDelimiter[static_cast<unsigned char>(c)] = true;
+    }
+
+    // decode the strings completed by the next size chars of the stream
+    void StreamDecoder::push(const char * chunk, size_t size) {
+        const char *last = chunk + size;
+        while (chunk != last) {
+            const char *end = std::find_if(chunk, last, [this](char c) {
+                return isDelimiter[static_cast<unsigned char>(c)];
+            });
+            append(chunk, end);
+            if (end == last)
+                break;
+            complete();
+            chunk = end + 1;
+        }
+    }
+
+    // end the stream, completing the last string
+    void StreamDecoder::finish() {
+        complete();
+    }
+
+    // add chars of the string in progress, none of which are delimiters
+    void StreamDecoder::append(const char * first, const char * last) {
+        if (tooLong || first == last)
+            return;
+        auto n = static_cast<size_t>(last - first);
+        if (n > lengthLimits.maxBech32Length - token.size()) {
+            token.append(first, lengthLimits.maxBech32Length - token.size());
+            tooLong = true;
+            return;
+        }
+        token.append(first, last);
+
+        // a new separator makes the data chars so far part of the HRP
+        const char *separator = last;
+        while (separator != first && separator[-1] != bech32::separator)
+            --separator;
+        if (separator != first) {
+            separatorPos = token.size() - static_cast<size_t>(last - separator) - 1;
+            values.clear();
+            dataChk = 0;
+            badData = false;
+            first = separator;
+        }
+        if (separatorPos == std::string::npos || badData || first == last)
+            return;
+
+        size_t oldSize = values.size();
+        values.resize(oldSize + static_cast<size_t>(last - first));
+        if (simd::mapChars(first, last, &values[oldSize]) != last) {
+            badData = true;
+            return;
+        }
+        dataChk = Bech32Generator::polymod(&values[oldSize], values.data() + values.size(), dataChk);
+    }
+
+    // report the string in progress, if there is one, and start a new one
+    void StreamDecoder::complete() {
+        if (token.empty())
+            return;
+        DecodedResult decoded = decodeToken();
+        ++completed;
+        callback(token, decoded);
+        token.clear();
+        separatorPos = std::string::npos;
+        values.clear();
+        dataChk = 0;
+        badData = false;
+        tooLong = false;
+    }
+
+    // the decode() result for the string in progress, with an Invalid encoding if decode()
+    // would throw or find a bad checksum
+    DecodedResult StreamDecoder::decodeToken() const {
+        DecodedResult ret = {Encoding::Invalid, std::string(), std::vector<unsigned char>()};
+        if (tooLong || badData || separatorPos == std::string::npos || token.size() < MIN_BECH32_LENGTH)
+            return ret;
+        if (separatorPos < MIN_HRP_LENGTH || separatorPos > lengthLimits.maxHrpLength ||
+            values.size() < CHECKSUM_LENGTH || !charsAreWellFormed(token))
+            return ret;
+
+        std::string hrp = token.substr(0, separatorPos);
+        std::transform(hrp.begin(), hrp.end(), hrp.begin(), ::tolower);
+        uint32_t hrpState = Bech32Generator::expandedHrp(hrp.data(), hrp.size());
+        uint32_t residue = Bech32Generator::shift(hrpState, values.size()) ^ dataChk;
+        if (Bech32mChecksum::verifyResidue(residue))
+            ret.encoding = Encoding::Bech32m;
+        else if (Bech32Checksum::verifyResidue(residue))
+            ret.encoding = Encoding::Bech32;
+        else
+            return ret;
+        ret.hrp = hrp;
+        ret.dp.assign(values.begin(), values.end() - CHECKSUM_LENGTH);
+        return ret;
+    }
+
+}
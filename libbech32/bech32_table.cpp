@@ -0,0 +1,350 @@
+#include "bech32_table.h"
+#include "bech32_packing.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+    const char magic[8] = {'B', '3', '2', 'T', 'A', 'B', 'L', 'E'};
+    const uint32_t version = 1;
+    const size_t headerSize = 40;
+
+    // size of a record, before its packed data
+    const size_t recordPrefixSize = 5;
+
+    using bech32::packing::packedBytes;
+
+    void putU16(unsigned char *p, uint16_t v) {
+        p[0] = static_cast<unsigned char>(v >> 8u);
+        p[1] = static_cast<unsigned char>(v);
+    }
+
+    void putU32(unsigned char *p, uint32_t v) {
+        for (int i = 0; i < 4; ++i)
+            p[i] = static_cast<unsigned char>(v >> (24 - 8 * i));
+    }
+
+    void putU64(unsigned char *p, uint64_t v) {
+        for (int i = 0; i < 8; ++i)
+            p[i] = static_cast<unsigned char>(v >> (56 - 8 * i));
+    }
+
+    uint16_t getU16(const unsigned char *p) {
+        return static_cast<uint16_t>(p[0] << 8u | p[1]);
+    }
+
+    uint32_t getU32(const unsigned char *p) {
+        uint32_t v = 0;
+        for (int i = 0; i < 4; ++i)
+            v = v << 8u | p[i];
+        return v;
+    }
+
+    uint64_t getU64(const unsigned char *p) {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; ++i)
+            v = v << 8u | p[i];
+        return v;
+    }
+
+    void rejectBadTable(bool bad) {
+        if (bad)
+            throw std::runtime_error("file is not a valid address table");
+    }
+
+    // map the whole file at path read-only, returning its address and setting size
+    const unsigned char *mapFile(const std::string &path, size_t &size) {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("could not open address table " + path);
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(headerSize)) {
+            CloseHandle(file);
+            rejectBadTable(true);
+        }
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr)
+            throw std::runtime_error("could not map address table " + path);
+        // the view keeps the mapping open
+        void *p = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (p == nullptr)
+            throw std::runtime_error("could not map address table " + path);
+        size = static_cast<size_t>(fileSize.QuadPart);
+        return static_cast<const unsigned char *>(p);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("could not open address table " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(headerSize)) {
+            ::close(fd);
+            rejectBadTable(true);
+        }
+        size = static_cast<size_t>(st.st_size);
+        void *p = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        // the mapping keeps the file open
+        ::close(fd);
+        if (p == MAP_FAILED)
+            throw std::runtime_error("could not map address table " + path);
+        return static_cast<const unsigned char *>(p);
+#endif
+    }
+
+    void unmapFile(const unsigned char *base, size_t size) {
+#ifdef _WIN32
+        (void) size;
+        UnmapViewOfFile(base);
+#else
+        ::munmap(const_cast<unsigned char *>(base), size);
+#endif
+    }
+
+}
+
+
+namespace bech32 {
+
+    // add a decoded payload
+    void AddressTableWriter::add(const DecodedResult &decoded) {
+        add(DecodedPackedResult{decoded.encoding, decoded.hrp, PackedData(decoded.dp)});
+    }
+
+    // add a decoded payload with a packed data part
+    void AddressTableWriter::add(const DecodedPackedResult &decoded) {
+        if (decoded.encoding == Encoding::Invalid)
+            throw std::runtime_error("an address table can only hold valid payloads");
+        if (decoded.dp.size() > 0xffff)
+            throw std::runtime_error("data part is too long for an address table");
+        Entry entry = {packed.size(), hrpIdOf(decoded.hrp), static_cast<uint8_t>(decoded.encoding),
+                       static_cast<uint16_t>(decoded.dp.size())};
+        const std::vector<unsigned char> &bytes = decoded.dp.packedBytes();
+        packed.insert(packed.end(), bytes.begin(), bytes.begin() + packedBytes(decoded.dp.size()));
+        entries.push_back(entry);
+    }
+
+    // decode a bech32 string and add it, returning false if it isn't valid
+    bool AddressTableWriter::add(const std::string &bstring, const LengthLimits &lengthLimits) {
+        DecodedPackedResult decoded;
+        try {
+            decoded = decodePacked(bstring, lengthLimits);
+        }
+        catch (std::runtime_error &) {
+            return false;
+        }
+        if (decoded.encoding == Encoding::Invalid || decoded.dp.size() > 0xffff)
+            return false;
+        add(decoded);
+        return true;
+    }
+
+    // the id of hrp (lowercased), which is added if it is new
+    HrpId AddressTableWriter::hrpIdOf(const std::string &hrp) {
+        std::string lower = hrp;
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+        auto it = std::find(hrps.begin(), hrps.end(), lower);
+        if (it != hrps.end())
+            return static_cast<HrpId>(it - hrps.begin());
+        if (lower.empty() || lower.size() > 0xffff || std::any_of(lower.begin(), lower.end(), [](char c) {
+                return c < limits::MIN_BECH32_CHAR_VALUE || c > limits::MAX_BECH32_CHAR_VALUE;
+            }))
+            throw std::runtime_error("HRP can't be stored in an address table");
+        if (hrps.size() + 1 >= HrpRegistry::unknownHrp)
+            throw std::runtime_error("too many HRPs for an address table");
+        hrps.push_back(lower);
+        return static_cast<HrpId>(hrps.size() - 1);
+    }
+
+    // write the table to the file at path
+    void AddressTableWriter::write(const std::string &path) const {
+        size_t maxDataLength = 0;
+        for (const Entry &entry : entries)
+            maxDataLength = std::max<size_t>(maxDataLength, entry.dataLength);
+        const size_t recordSize = recordPrefixSize + packedBytes(maxDataLength);
+
+        // lay out every record, then sort and drop duplicates by index
+        std::vector<unsigned char> records(entries.size() * recordSize);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const Entry &entry = entries[i];
+            unsigned char *r = &records[i * recordSize];
+            putU16(r, entry.hrpId);
+            r[2] = entry.encoding;
+            putU16(r + 3, entry.dataLength);
+            std::memcpy(r + recordPrefixSize, packed.data() + entry.offset, packedBytes(entry.dataLength));
+        }
+        std::vector<size_t> order(entries.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+        const unsigned char *r = records.data();
+        std::sort(order.begin(), order.end(), [r, recordSize](size_t a, size_t b) {
+            return std::memcmp(r + a * recordSize, r + b * recordSize, recordSize) < 0;
+        });
+        order.erase(std::unique(order.begin(), order.end(), [r, recordSize](size_t a, size_t b) {
+            return std::memcmp(r + a * recordSize, r + b * recordSize, recordSize) == 0;
+        }), order.end());
+
+        std::vector<unsigned char> head(headerSize);
+        for (const std::string &hrp : hrps) {
+            unsigned char size[2];
+            putU16(size, static_cast<uint16_t>(hrp.size()));
+            head.insert(head.end(), size, size + 2);
+            head.insert(head.end(), hrp.begin(), hrp.end());
+        }
+        head.resize((head.size() + 7) / 8 * 8);
+        std::memcpy(head.data(), magic, sizeof(magic));
+        putU32(&head[8], version);
+        putU32(&head[12], static_cast<uint32_t>(hrps.size()));
+        putU32(&head[16], static_cast<uint32_t>(maxDataLength));
+        putU32(&head[20], static_cast<uint32_t>(recordSize));
+        putU64(&head[24], order.size());
+        putU64(&head[32], head.size());
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(head.data()), static_cast<std::streamsize>(head.size()));
+        for (size_t i : order)
+            out.write(reinterpret_cast<const char *>(r + i * recordSize), static_cast<std::streamsize>(recordSize));
+        out.close();
+        if (!out)
+            throw std::runtime_error("could not write address table " + path);
+    }
+
+    // convert newline-delimited bech32 strings to an address table
+    std::vector<size_t> convertAddressText(std::istream &in, const std::string &path,
+                                           const LengthLimits &lengthLimits) {
+        AddressTableWriter writer;
+        std::vector<size_t> badLines;
+        std::string line;
+        for (size_t lineNumber = 1; std::getline(in, line); ++lineNumber) {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (line.empty())
+                continue;
+            if (!writer.add(line, lengthLimits))
+                badLines.push_back(lineNumber);
+        }
+        writer.write(path);
+        return badLines;
+    }
+
+    const size_t AddressTable::npos;
+
+    // map the address table at path
+    AddressTable::AddressTable(const std::string &path)
+            : base(nullptr), mappedSize(0), recordCount(0), recordSize(0), maxDataLength(0), records(nullptr),
+              registry(std::vector<std::string>()) {
+        base = mapFile(path, mappedSize);
+        try {
+            rejectBadTable(std::memcmp(base, magic, sizeof(magic)) != 0 || getU32(base + 8) != version);
+            uint32_t hrpCount = getU32(base + 12);
+            maxDataLength = getU32(base + 16);
+            recordSize = getU32(base + 20);
+            uint64_t count = getU64(base + 24);
+            uint64_t recordsOffset = getU64(base + 32);
+            rejectBadTable(maxDataLength > 0xffff || recordSize != recordPrefixSize + packedBytes(maxDataLength));
+            rejectBadTable(recordsOffset > mappedSize || count > (mappedSize - recordsOffset) / recordSize);
+            recordCount = static_cast<size_t>(count);
+            records = base + recordsOffset;
+
+            const unsigned char *p = base + headerSize;
+            for (uint32_t i = 0; i < hrpCount; ++i) {
+                rejectBadTable(records - p < 2);
+                size_t size = getU16(p);
+                rejectBadTable(static_cast<size_t>(records - p - 2) < size);
+                hrpList.emplace_back(reinterpret_cast<const char *>(p + 2), size);
+                p += 2 + size;
+            }
+            registry = HrpRegistry(hrpList);
+        }
+        catch (...) {
+            unmapFile(base, mappedSize);
+            throw;
+        }
+    }
+
+    AddressTable::~AddressTable() {
+        unmapFile(base, mappedSize);
+    }
+
+    // the payload of the record at index i
+    DecodedResult AddressTable::operator[](size_t i) const {
+        const unsigned char *r = records + i * recordSize;
+        HrpId hrpId = getU16(r);
+        uint16_t dataLength = getU16(r + 3);
+        rejectBadTable(hrpId >= hrpList.size() || dataLength > maxDataLength ||
+                       (r[2] != Encoding::Bech32 && r[2] != Encoding::Bech32m));
+
+        DecodedResult ret = {static_cast<Encoding>(r[2]), hrpList[hrpId], std::vector<unsigned char>(dataLength)};
+        packing::unpackValues(r + recordPrefixSize, dataLength, ret.dp.data());
+        return ret;
+    }
+
+    // make the key of a payload, returning false if it can't be in the table
+    bool AddressTable::makeKey(HrpId hrpId, Encoding encoding, const std::vector<unsigned char> &dp,
+                               std::vector<unsigned char> &key) const {
+        if (hrpId == HrpRegistry::unknownHrp || encoding == Encoding::Invalid || dp.size() > maxDataLength)
+            return false;
+        // values out of range can't be in the table
+        if (std::any_of(dp.begin(), dp.end(), [](unsigned char v) { return v > 31; }))
+            return false;
+        key.assign(recordSize, 0);
+        putU16(key.data(), hrpId);
+        key[2] = static_cast<unsigned char>(encoding);
+        putU16(key.data() + 3, static_cast<uint16_t>(dp.size()));
+        packing::packValues(dp.data(), dp.size(), key.data() + recordPrefixSize);
+        return true;
+    }
+
+    // binary search for a record equal to key
+    size_t AddressTable::findRecord(const unsigned char *key) const {
+        size_t lo = 0, hi = recordCount;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            int cmp = std::memcmp(records + mid * recordSize, key, recordSize);
+            if (cmp == 0)
+                return mid;
+            if (cmp < 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return npos;
+    }
+
+    // return the index of the record for a decoded payload, or npos
+    size_t AddressTable::find(const DecodedResult &decoded) const {
+        std::vector<unsigned char> key;
+        if (!makeKey(registry.find(decoded.hrp.data(), decoded.hrp.size()), decoded.encoding, decoded.dp, key))
+            return npos;
+        return findRecord(key.data());
+    }
+
+    // return the index of the record for the payload of a bech32 string, or npos
+    size_t AddressTable::find(const std::string &bstring, const LengthLimits &lengthLimits) const {
+        DecodedIdResult decoded;
+        try {
+            decoded = decode(bstring, registry, lengthLimits);
+        }
+        catch (std::runtime_error &) {
+            return npos;
+        }
+        std::vector<unsigned char> key;
+        if (!makeKey(decoded.hrpId, decoded.encoding, decoded.dp, key))
+            return npos;
+        return findRecord(key.data());
+    }
+
+}
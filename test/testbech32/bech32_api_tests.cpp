@@ -160,6 +160,36 @@ void decode_and_encode_longExample_producesSameResult() {
     assert(bstr1 == bstr2);
 }
 
+void decode_longExample_withUnlimitedLength_isSuccessful() {
+    // a BOLT11 lightning invoice, longer than the 90 chars allowed by BIP-0173
+    std::string bstr =
+            "lnbc1pvjluezpp5qqqsyqcyq5rqwzqfqqqsyqcyq5rqwzqfqqqsyqcyq5rqwzqfqypqdpl2pkx2ctnv5sxxmmwwd5kge"
+            "tjypeh2ursdae8g6twvus8g6rfwvs8qun0dfjkxaq8rkx3yf5tcsyz3d73gafnh3cax9rn449d9p5uxz9ezhhypd0elx87"
+            "sjle52x86fux2ypatgddc6k63n7erqz25le42c4u4ecky03ylcqca784w";
+    std::string expectedHrp = "lnbc";
+
+    bech32::DecodedResult decodedResult = bech32::decode<bech32::UnlimitedLength>(bstr);
+
+    assert(expectedHrp == decodedResult.hrp);
+    assert(bech32::Encoding::Bech32 == decodedResult.encoding);
+
+    std::string bstr2 = bech32::encodeUsingOriginalConstant(
+            decodedResult.hrp, decodedResult.dp, bech32::limits::UNLIMITED_LENGTH);
+
+    assert(bstr == bstr2);
+}
+
+void transcode_smallExample_producesSameResultAsDecodeAndEncode() {
+    std::string bstr1 = "xyz1pzrs3usye";
+
+    bech32::DecodedResult decodedResult = bech32::decode(bstr1);
+
+    std::string bstr2 = bech32::transcode(bstr1, "abc", bech32::Encoding::Bech32);
+
+    assert(bstr2 == bech32::encodeUsingOriginalConstant("abc", decodedResult.dp));
+    assert(bstr1 == bech32::transcode(bstr2, "xyz", bech32::Encoding::Bech32m));
+}
+
 // ---------- tests using original checksum constant = 1 ------------
 
 void decode_c1_minimalExample_isSuccessful() {
@@ -262,6 +292,8 @@ void tests_using_default_checksum_constant() {
     decode_and_encode_minimalExample_producesSameResult();
     decode_and_encode_smallExample_producesSameResult();
     decode_and_encode_longExample_producesSameResult();
+
+    transcode_smallExample_producesSameResultAsDecodeAndEncode();
 }
 
 void tests_using_original_checksum_constant() {
@@ -274,6 +306,8 @@ void tests_using_original_checksum_constant() {
     decode_and_encode_c1_minimalExample_producesSameResult();
     decode_and_encode_c1_smallExample_producesSameResult();
     decode_and_encode_c1_longExample_producesSameResult();
+
+    decode_longExample_withUnlimitedLength_isSuccessful();
 }
 
 int main() {
@@ -480,6 +480,22 @@ void decode_and_encode_c1_longExample_producesSameResult(void) {
 }
 
 
+void isValid_withNullInput_isInvalid(void) {
+    assert(bech32_is_valid(NULL) == 0);
+    assert(bech32_detect_encoding(NULL) == ENCODING_INVALID);
+}
+
+void isValid_minimalExample_isValid(void) {
+    assert(bech32_is_valid("a1lqfn3a") == 1);
+    assert(bech32_detect_encoding("a1lqfn3a") == ENCODING_BECH32M);
+    assert(bech32_detect_encoding("a12uel5l") == ENCODING_BECH32);
+}
+
+void isValid_minimalExampleBadChecksum_isInvalid(void) {
+    assert(bech32_is_valid("a1lqfn3q") == 0);
+    assert(bech32_detect_encoding("a1lqfn3q") == ENCODING_INVALID);
+}
+
 void test_strerror(void) {
     strerror_withValidErrorCode_returnsErrorMessage();
     strerror_withInvalidErrorCode_returnsUnknownErrorMessage();
@@ -494,6 +510,12 @@ void test_stripUnknownChars(void) {
     stripUnknownChars_withFunkyString_returnsStrippedString();
 }
 
+void test_isValid(void) {
+    isValid_withNullInput_isInvalid();
+    isValid_minimalExample_isValid();
+    isValid_minimalExampleBadChecksum_isInvalid();
+}
+
 void create_DecodedResult_storage_withNullInput_returnsNull(void) {
     bech32_DecodedResult *p = bech32_create_DecodedResult(NULL);
     assert(p == NULL);
@@ -644,6 +666,7 @@ int main(void) {
 
     test_strerror();
     test_stripUnknownChars();
+    test_isValid();
     test_memoryAllocation();
 
     tests_using_default_checksum_constant();
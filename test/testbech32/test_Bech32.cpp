@@ -1,4 +1,12 @@
 #include "bech32.cpp"
+#include "bech32_base32.h"
+#include "bech32_cache.h"
+#include "bech32_canonical.h"
+#include "bech32_columnar.h"
+#include "bech32_packing.h"
+#include "bech32_set.h"
+#include "bech32_stream.h"
+#include "bech32_table.h"
 
 #include <gtest/gtest.h>
 #pragma clang diagnostic push
@@ -10,6 +18,16 @@
 #pragma clang diagnostic pop
 #pragma GCC diagnostic pop
 
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
 // check that we reject strings less than 8 chars in length
 TEST(Bech32Test, ensure_correct_data_size_low) {
     std::string data(7, 'a');
@@ -425,81 +443,159 @@ TEST(Bech32Test, map_data) {
 // check that we can expand the hrp
 TEST(Bech32Test, expand_hrp) {
     std::string hrp("ABC");
-    std::vector<unsigned char> e = expandHrp(hrp);
-    ASSERT_EQ(e[0], '\x02');
-    ASSERT_EQ(e[1], '\x02');
-    ASSERT_EQ(e[2], '\x02');
-    ASSERT_EQ(e[3], '\x00');
-    ASSERT_EQ(e[4], '\x01');
-    ASSERT_EQ(e[5], '\x02');
-    ASSERT_EQ(e[6], '\x03');
+    // the high bits of each char, a zero, then the low bits of each char
+    std::vector<unsigned char> e = {'\x02', '\x02', '\x02', '\x00', '\x01', '\x02', '\x03'};
+    ASSERT_EQ(bech32::Bech32Generator::expandedHrp(hrp.data(), hrp.size()),
+              bech32::Bech32Generator::polymod(e.data(), e.data() + e.size()));
 }
 
 // check the polymod method
 TEST(Bech32Test, polymod) {
     std::string hrp("A");
-    std::vector<unsigned char> e = expandHrp(hrp);
-    uint32_t p = polymod(e);
+    uint32_t p = bech32::Bech32Generator::expandedHrp(hrp.data(), hrp.size());
     ASSERT_EQ(p, 34817);
 
     hrp = "B";
-    e = expandHrp(hrp);
-    p = polymod(e);
+    p = bech32::Bech32Generator::expandedHrp(hrp.data(), hrp.size());
     ASSERT_EQ(p, 34818);
 
     hrp = "qwerty";
-    e = expandHrp(hrp);
-    p = polymod(e);
+    p = bech32::Bech32Generator::expandedHrp(hrp.data(), hrp.size());
     ASSERT_EQ(p, 448484437);
 }
 
-// check the verifyChecksum method
+// check that shifting a checksum state by n is the same as running polymod over n zeros
+TEST(Bech32Test, shift) {
+    typedef bech32::Bech32Generator G;
+    std::vector<unsigned char> zeros(1000);
+    for (size_t n : {0, 1, 5, 6, 7, 100, 1000}) {
+        uint32_t expected = G::serial(zeros.data(), zeros.data() + n, 448484437);
+        ASSERT_EQ(G::shift(448484437, n), expected);
+    }
+}
+
+template<typename G>
+void checkFastPolymodMatchesSerialPolymod(const std::vector<unsigned char> &values) {
+    const unsigned char *first = values.data();
+    const unsigned char *last = first + values.size();
+
+    typename G::state_type expected = G::serial(first, last, 1);
+    RC_ASSERT(G::folded(first, last, 1) == expected);
+    RC_ASSERT(G::interleaved(first, last, 1) == expected);
+    RC_ASSERT(G::chunked(first, last, 1, 4) == expected);
+    RC_ASSERT(G::polymod(first, last, 1) == expected);
+}
+
+RC_GTEST_PROP(Bech32TestRC, fastPolymodMatchesSerialPolymod, ()
+) {
+    // generate data values in the range 0-31, long enough to be split into chunks
+    const auto values =
+            *rc::gen::container<std::vector<unsigned char>>(
+                    *rc::gen::inRange<size_t>(0, 10000),
+                    rc::gen::inRange<unsigned char>(0, 31));
+
+    checkFastPolymodMatchesSerialPolymod<bech32::Bech32Generator>(values);
+    checkFastPolymodMatchesSerialPolymod<bech32::Blech32Generator>(values);
+}
+
+// check that splitting a long input across threads gives the same result
+TEST(Bech32Test, polymod_threaded) {
+    typedef bech32::Bech32Generator G;
+    std::vector<unsigned char> values(G::minThreadedLength * 3 + 17);
+    for (size_t i = 0; i < values.size(); ++i)
+        values[i] = static_cast<unsigned char>((i * 7 + i / 32) & 31u);
+    const unsigned char *first = values.data();
+    const unsigned char *last = first + values.size();
+
+    uint32_t expected = G::serial(first, last, 1);
+    ASSERT_EQ(G::chunked(first, last, 1, 2), expected);
+    ASSERT_EQ(G::chunked(first, last, 1, 5), expected);
+}
+
+// check that the step of the generic engine matches the bech32 step from BIP-0173
+TEST(Bech32Test, generic_step) {
+    for (uint32_t chk : {1u, 34817u, 448484437u, 0x3fffffffu, 0x2bc830a3u}) {
+        for (unsigned char v = 0; v < 32; ++v) {
+            auto top = static_cast<uint8_t>(chk >> 25u);
+            uint32_t expected = (chk & 0x1ffffffu) << 5u ^ v ^
+                    (-((top >> 0) & 1u) & 0x3b6a57b2UL) ^
+                    (-((top >> 1) & 1u) & 0x26508e6dUL) ^
+                    (-((top >> 2) & 1u) & 0x1ea119faUL) ^
+                    (-((top >> 3) & 1u) & 0x3d4233ddUL) ^
+                    (-((top >> 4) & 1u) & 0x2a1462b3UL);
+            ASSERT_EQ(bech32::Bech32Generator::step(chk, v), expected);
+        }
+    }
+}
+
+// check that blech32 checksums can be created and verified, and detect a changed symbol
+TEST(Bech32Test, blech32_checksum) {
+    std::string hrp = "lq";
+    std::vector<unsigned char> dp = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 31, 30, 29};
+
+    std::vector<unsigned char> checksum = bech32::Blech32mChecksum::create(hrp, dp);
+    ASSERT_EQ(checksum.size(), 12);
+    std::vector<unsigned char> full = cat(dp, checksum);
+    ASSERT_TRUE(bech32::Blech32mChecksum::verify(hrp, full));
+    ASSERT_FALSE(bech32::Blech32Checksum::verify(hrp, full));
+
+    for (size_t i = 0; i < full.size(); ++i) {
+        std::vector<unsigned char> changed = full;
+        changed[i] ^= 1u;
+        ASSERT_FALSE(bech32::Blech32mChecksum::verify(hrp, changed));
+    }
+
+    checksum = bech32::Blech32Checksum::create(hrp, dp);
+    ASSERT_TRUE(bech32::Blech32Checksum::verify(hrp, cat(dp, checksum)));
+}
+
+// check the Bech32m checksum verify method
 TEST(Bech32Test, verifyChecksum_good) {
     std::string str("a1lqfn3a");
     std::string hrp = extractHumanReadablePart(str);
     std::vector<unsigned char> dp = extractDataPart(str);
     convertToLowercase(hrp);
     mapDP(dp);
-    ASSERT_TRUE(verifyChecksum(hrp, dp));
+    ASSERT_TRUE(bech32::Bech32mChecksum::verify(hrp, dp));
 
     str = "A1LQFN3A";
     hrp = extractHumanReadablePart(str);
     dp = extractDataPart(str);
     convertToLowercase(hrp);
     mapDP(dp);
-    ASSERT_TRUE(verifyChecksum(hrp, dp));
+    ASSERT_TRUE(bech32::Bech32mChecksum::verify(hrp, dp));
 
     str = "abcdef1l7aum6echk45nj3s0wdvt2fg8x9yrzpqzd3ryx";
     hrp = extractHumanReadablePart(str);
     dp = extractDataPart(str);
     convertToLowercase(hrp);
     mapDP(dp);
-    ASSERT_TRUE(verifyChecksum(hrp, dp));
+    ASSERT_TRUE(bech32::Bech32mChecksum::verify(hrp, dp));
 
     str = "split1checkupstagehandshakeupstreamerranterredcaperredlc445v";
     hrp = extractHumanReadablePart(str);
     dp = extractDataPart(str);
     convertToLowercase(hrp);
     mapDP(dp);
-    ASSERT_TRUE(verifyChecksum(hrp, dp));
+    ASSERT_TRUE(bech32::Bech32mChecksum::verify(hrp, dp));
 
     str = "an83characterlonghumanreadablepartthatcontainsthetheexcludedcharactersbioandnumber11sg7hg6";
     hrp = extractHumanReadablePart(str);
     dp = extractDataPart(str);
     convertToLowercase(hrp);
     mapDP(dp);
-    ASSERT_TRUE(verifyChecksum(hrp, dp));
+    ASSERT_TRUE(bech32::Bech32mChecksum::verify(hrp, dp));
 
     str = "11llllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllludsr8";
     hrp = extractHumanReadablePart(str);
     dp = extractDataPart(str);
     convertToLowercase(hrp);
     mapDP(dp);
-    ASSERT_TRUE(verifyChecksum(hrp, dp));
+    ASSERT_TRUE(bech32::Bech32mChecksum::verify(hrp, dp));
 
 }
 
-// check the verifyChecksum method
+// check the Bech32m checksum verify method
 // these are simply the "good" tests from above with a single character changed
 TEST(Bech32Test, verifyChecksum_bad) {
     std::string str("a1lqfn33");
@@ -507,42 +603,42 @@ TEST(Bech32Test, verifyChecksum_bad) {
     std::vector<unsigned char> dp = extractDataPart(str);
     convertToLowercase(hrp);
     mapDP(dp);
-    ASSERT_FALSE(verifyChecksum(hrp, dp));
+    ASSERT_FALSE(bech32::Bech32mChecksum::verify(hrp, dp));
 
     str = "A1LQFN33";
     hrp = extractHumanReadablePart(str);
     dp = extractDataPart(str);
     convertToLowercase(hrp);
     mapDP(dp);
-    ASSERT_FALSE(verifyChecksum(hrp, dp));
+    ASSERT_FALSE(bech32::Bech32mChecksum::verify(hrp, dp));
 
     str = "abcdef1l7aum6echk45nj3s0wdvt2fg8x9yrzpqzd3ryy";
     hrp = extractHumanReadablePart(str);
     dp = extractDataPart(str);
     convertToLowercase(hrp);
     mapDP(dp);
-    ASSERT_FALSE(verifyChecksum(hrp, dp));
+    ASSERT_FALSE(bech32::Bech32mChecksum::verify(hrp, dp));
 
     str = "split1checkupstagehandshakeupstreamerranterredcaperredlc445s";
     hrp = extractHumanReadablePart(str);
     dp = extractDataPart(str);
     convertToLowercase(hrp);
     mapDP(dp);
-    ASSERT_FALSE(verifyChecksum(hrp, dp));
+    ASSERT_FALSE(bech32::Bech32mChecksum::verify(hrp, dp));
 
     str = "an83characterlonghumanreadablepartthatcontainsthetheexcludedcharactersbioandnumber11sg7hg7";
     hrp = extractHumanReadablePart(str);
     dp = extractDataPart(str);
     convertToLowercase(hrp);
     mapDP(dp);
-    ASSERT_FALSE(verifyChecksum(hrp, dp));
+    ASSERT_FALSE(bech32::Bech32mChecksum::verify(hrp, dp));
 
     str = "11llllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllludsrc";
     hrp = extractHumanReadablePart(str);
     dp = extractDataPart(str);
     convertToLowercase(hrp);
     mapDP(dp);
-    ASSERT_FALSE(verifyChecksum(hrp, dp));
+    ASSERT_FALSE(bech32::Bech32mChecksum::verify(hrp, dp));
 }
 
 // check the main bech32 decode method
@@ -568,6 +664,1400 @@ TEST(Bech32Test, decode_good) {
     ASSERT_EQ(b.dp[31], '\0');  // last 'q' in above dp part
 }
 
+// a BOLT11 lightning invoice is a bech32 string longer than 90 chars
+const char *bolt11Invoice =
+        "lnbc1pvjluezpp5qqqsyqcyq5rqwzqfqqqsyqcyq5rqwzqfqqqsyqcyq5rqwzqfqypqdpl2pkx2ctnv5sxxmmwwd5kge"
+        "tjypeh2ursdae8g6twvus8g6rfwvs8qun0dfjkxaq8rkx3yf5tcsyz3d73gafnh3cax9rn449d9p5uxz9ezhhypd0elx87"
+        "sjle52x86fux2ypatgddc6k63n7erqz25le42c4u4ecky03ylcqca784w";
+
+// check that long strings are only decoded when the length limits allow them
+TEST(Bech32Test, decode_long) {
+    std::string data(bolt11Invoice);
+    ASSERT_THROW(bech32::decode(data), std::runtime_error);
+
+    bech32::DecodedResult b = bech32::decode<bech32::UnlimitedLength>(data);
+    ASSERT_EQ(b.encoding, bech32::Encoding::Bech32);
+    ASSERT_EQ(b.hrp, "lnbc");
+    ASSERT_EQ(b.dp.size(), data.size() - 4 - 1 - 6);
+
+    bech32::DecodedResult c = bech32::decode(data, bech32::limits::UNLIMITED_LENGTH);
+    ASSERT_EQ(c.dp, b.dp);
+
+    bech32::LengthLimits tooShort = {83, 242};
+    ASSERT_THROW(bech32::decode(data, tooShort), std::runtime_error);
+    bech32::LengthLimits hrpTooShort = {3, 1000};
+    ASSERT_THROW(bech32::decode(data, hrpTooShort), std::runtime_error);
+}
+
+// check that long strings are only encoded when the length limits allow them
+TEST(Bech32Test, encode_long) {
+    std::string data(bolt11Invoice);
+    bech32::DecodedResult b = bech32::decode<bech32::UnlimitedLength>(data);
+
+    ASSERT_THROW(bech32::encodeUsingOriginalConstant(b.hrp, b.dp), std::runtime_error);
+    ASSERT_EQ(bech32::encodeUsingOriginalConstant<bech32::UnlimitedLength>(b.hrp, b.dp), data);
+    ASSERT_EQ(bech32::encodeUsingOriginalConstant(b.hrp, b.dp, bech32::limits::UNLIMITED_LENGTH), data);
+
+    std::string hrp(100, 'a');
+    ASSERT_THROW(bech32::encode(hrp, b.dp), std::runtime_error);
+    std::string bstr = bech32::encode<bech32::UnlimitedLength>(hrp, b.dp);
+    bech32::DecodedResult c = bech32::decode<bech32::UnlimitedLength>(bstr);
+    ASSERT_EQ(c.encoding, bech32::Encoding::Bech32m);
+    ASSERT_EQ(c.hrp, hrp);
+    ASSERT_EQ(c.dp, b.dp);
+}
+
+RC_GTEST_PROP(Bech32TestRC, encodeThenDecodeLongStringsShouldProduceInitialData, ()
+) {
+    // generate a data part of up to 5000 values, each in the range 0-31
+    const auto data =
+            *rc::gen::container<std::vector<unsigned char>>(
+                    *rc::gen::inRange<size_t>(0, 5000),
+                    rc::gen::inRange<unsigned char>(0, 31));
+
+    std::string bstr = bech32::encode<bech32::UnlimitedLength>("long", data);
+    bech32::DecodedResult b = bech32::decode<bech32::UnlimitedLength>(bstr);
+
+    RC_ASSERT(b.encoding == bech32::Encoding::Bech32m);
+    RC_ASSERT(b.hrp == "long");
+    RC_ASSERT(data == b.dp);
+}
+
+// check that the cheaper decode modes give the same results as a full decode for valid strings
+TEST(Bech32Test, decode_modes) {
+    std::string addr = "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4";
+    bech32::DecodedResult b = bech32::decode(addr);
+
+    bech32::DecodedResult c = bech32::decode(addr, bech32::DecodeMode::FullValidation);
+    ASSERT_EQ(c.encoding, bech32::Encoding::Bech32);
+    ASSERT_EQ(c.hrp, b.hrp);
+    ASSERT_EQ(c.dp, b.dp);
+
+    c = bech32::decode(addr, bech32::DecodeMode::ChecksumOnly);
+    ASSERT_EQ(c.encoding, bech32::Encoding::Bech32);
+    ASSERT_EQ(c.hrp, b.hrp);
+    ASSERT_EQ(c.dp, b.dp);
+
+    c = bech32::decode(addr, bech32::DecodeMode::LayoutOnly);
+    ASSERT_EQ(c.encoding, bech32::Encoding::Invalid);
+    ASSERT_EQ(c.hrp, b.hrp);
+    ASSERT_EQ(c.dp, b.dp);
+
+    // long strings are not rejected by the trusted modes
+    c = bech32::decode(bolt11Invoice, bech32::DecodeMode::ChecksumOnly);
+    ASSERT_EQ(c.encoding, bech32::Encoding::Bech32);
+    ASSERT_EQ(c.hrp, "lnbc");
+    ASSERT_THROW(bech32::decode(bolt11Invoice, bech32::DecodeMode::FullValidation), std::runtime_error);
+}
+
+TEST(Bech32Test, decode_modes_bad) {
+    std::string badChecksum = "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t5";
+    ASSERT_EQ(bech32::decode(badChecksum, bech32::DecodeMode::ChecksumOnly).encoding, bech32::Encoding::Invalid);
+    ASSERT_TRUE(bech32::decode(badChecksum, bech32::DecodeMode::ChecksumOnly).hrp.empty());
+    ASSERT_EQ(bech32::decode(badChecksum, bech32::DecodeMode::LayoutOnly).hrp, "bc");
+
+    // strings that can't be split give an empty result rather than throwing
+    const char *unsplittable[] = {"", "qw508d6qejxtdg4y5r3zar", "1qw508d6", "bc1qw508", "bc1\x80\xff"};
+    for (const char *bstr : unsplittable) {
+        for (bech32::DecodeMode mode : {bech32::DecodeMode::ChecksumOnly, bech32::DecodeMode::LayoutOnly}) {
+            bech32::DecodedResult b = bech32::decode(bstr, mode);
+            ASSERT_EQ(b.encoding, bech32::Encoding::Invalid);
+            ASSERT_TRUE(b.hrp.empty());
+            ASSERT_TRUE(b.dp.empty());
+        }
+    }
+
+    // chars outside the charset are not detected, but map to values in range
+    bech32::DecodedResult b = bech32::decode("bc1\x80\xff" "bio~~~", bech32::DecodeMode::LayoutOnly);
+    ASSERT_EQ(b.hrp, "bc");
+    ASSERT_EQ(b.dp.size(), 2u);
+    ASSERT_LT(b.dp[0], 32);
+    ASSERT_LT(b.dp[1], 32);
+}
+
+RC_GTEST_PROP(Bech32TestRC, trustedDecodeShouldMatchFullDecode, ()
+) {
+    const auto hrp = *rc::gen::nonEmpty(
+            rc::gen::container<std::string>(
+                    rc::gen::oneOf(
+                            rc::gen::inRange('a', 'z'),
+                            rc::gen::inRange('0', '9'))));
+    const auto data =
+            *rc::gen::container<std::vector<unsigned char>>(
+                    *rc::gen::inRange<size_t>(0, 2000),
+                    rc::gen::inRange<unsigned char>(0, 31));
+
+    std::string bstr = bech32::encode<bech32::UnlimitedLength>(hrp, data);
+    bech32::DecodedResult b = bech32::decode(bstr, bech32::DecodeMode::ChecksumOnly);
+    RC_ASSERT(b.encoding == bech32::Encoding::Bech32m);
+    RC_ASSERT(b.hrp == hrp);
+    RC_ASSERT(b.dp == data);
+
+    b = bech32::decode(bstr, bech32::DecodeMode::LayoutOnly);
+    RC_ASSERT(b.hrp == hrp);
+    RC_ASSERT(b.dp == data);
+}
+
+TEST(Bech32Test, decode_expected_hrp) {
+    std::string addr = "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4";
+    bech32::DecodedResult b = bech32::decode(addr);
+
+    bech32::DecodedResult c = bech32::decode(addr, "bc");
+    ASSERT_EQ(c.encoding, bech32::Encoding::Bech32);
+    ASSERT_EQ(c.hrp, "bc");
+    ASSERT_EQ(c.dp, b.dp);
+
+    // HRPs are compared ignoring case
+    ASSERT_EQ(bech32::decode(addr, "BC").dp, b.dp);
+    ASSERT_EQ(bech32::decode("BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4", "bc").dp, b.dp);
+
+    // mismatches give an empty result, without checking the rest of the string
+    const char *wrongHrp[] = {"tb", "b", "bcrt", "bc1"};
+    for (const char *hrp : wrongHrp) {
+        c = bech32::decode(addr, hrp);
+        ASSERT_EQ(c.encoding, bech32::Encoding::Invalid);
+        ASSERT_TRUE(c.hrp.empty());
+        ASSERT_TRUE(c.dp.empty());
+    }
+    ASSERT_TRUE(bech32::decode("tb1 not a valid string", "bc").hrp.empty());
+    ASSERT_TRUE(bech32::decode("no separator", "bc").hrp.empty());
+
+    // an empty HRP is rejected, as by decode(), even for a string that has one
+    std::string noHrp = "1" + bech32::encode("a", {}).substr(2);
+    ASSERT_THROW(bech32::decode(addr, ""), std::runtime_error);
+    ASSERT_THROW(bech32::decode(noHrp, ""), std::runtime_error);
+    ASSERT_THROW(bech32::decode(noHrp), std::runtime_error);
+
+    // switching between HRPs gives each its own checksum state
+    std::string tbAddr = bech32::encodeUsingOriginalConstant("tb", b.dp);
+    ASSERT_EQ(bech32::decode(tbAddr, "tb").dp, b.dp);
+    ASSERT_EQ(bech32::decode(addr, "bc").dp, b.dp);
+    ASSERT_EQ(bech32::decode(tbAddr, "TB").hrp, "tb");
+
+    // strings with a matching HRP are checked as by decode()
+    ASSERT_THROW(bech32::decode("bc1 not a valid string", "bc"), std::runtime_error);
+    ASSERT_EQ(bech32::decode("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t5", "bc").encoding,
+              bech32::Encoding::Invalid);
+    ASSERT_THROW(bech32::decode(bolt11Invoice, "lnbc"), std::runtime_error);
+    ASSERT_EQ(bech32::decode(bolt11Invoice, "lnbc", bech32::limits::UNLIMITED_LENGTH).hrp, "lnbc");
+}
+
+TEST(Bech32Test, decode_expected_hrps) {
+    bech32::ExpectedHrps expected({"bc", "TB", "bcrt"});
+    ASSERT_EQ(expected.find("tb", 2), 1u);
+    ASSERT_EQ(expected.find("BCRT", 4), 2u);
+    ASSERT_EQ(expected.find("bcr", 3), bech32::ExpectedHrps::npos);
+    ASSERT_EQ(expected.hrp(1), "tb");
+
+    std::vector<unsigned char> data = {0, 14, 20, 15, 7, 13, 26, 0, 25, 18, 6, 11, 13, 8, 21, 4};
+    for (const char *hrp : {"bc", "tb", "bcrt"}) {
+        std::string bstr = bech32::encode(hrp, data);
+        bech32::DecodedResult b = bech32::decode(bstr, expected);
+        ASSERT_EQ(b.encoding, bech32::Encoding::Bech32m);
+        ASSERT_EQ(b.hrp, hrp);
+        ASSERT_EQ(b.dp, data);
+    }
+
+    bech32::DecodedResult b = bech32::decode(bech32::encode("ltc", data), expected);
+    ASSERT_EQ(b.encoding, bech32::Encoding::Invalid);
+    ASSERT_TRUE(b.hrp.empty());
+
+    ASSERT_THROW(bech32::ExpectedHrps({"bc", ""}), std::runtime_error);
+    ASSERT_THROW(bech32::ExpectedHrps({"b c"}), std::runtime_error);
+}
+
+TEST(Bech32Test, hrp_registry) {
+    bech32::HrpRegistry registry({"bc", "TB", "bcrt", "lnbc", "ltc"});
+    ASSERT_EQ(registry.size(), 5u);
+    ASSERT_EQ(registry.find("bc", 2), 0);
+    ASSERT_EQ(registry.find("tb", 2), 1);
+    ASSERT_EQ(registry.find("BCRT", 4), 2);
+    ASSERT_EQ(registry.find("lnbc1", 4), 3);
+    ASSERT_EQ(registry.find("bcr", 3), bech32::HrpRegistry::unknownHrp);
+    ASSERT_EQ(registry.find("", 0), bech32::HrpRegistry::unknownHrp);
+    ASSERT_EQ(registry.hrp(1), "tb");
+    ASSERT_EQ(registry.checksumState(1), bech32::Bech32Generator::expandedHrp("tb", 2));
+
+    ASSERT_THROW(bech32::HrpRegistry({"bc", ""}), std::runtime_error);
+    ASSERT_THROW(bech32::HrpRegistry({"b c"}), std::runtime_error);
+    ASSERT_THROW(bech32::HrpRegistry({"bc", "BC"}), std::runtime_error);
+
+    bech32::HrpRegistry empty({});
+    ASSERT_EQ(empty.find("bc", 2), bech32::HrpRegistry::unknownHrp);
+}
+
+TEST(Bech32Test, hrp_registry_many) {
+    std::vector<std::string> hrps;
+    for (int i = 0; i < 1000; ++i)
+        hrps.push_back("hrp" + std::to_string(i));
+    bech32::HrpRegistry registry(hrps);
+    for (size_t i = 0; i < hrps.size(); ++i) {
+        ASSERT_EQ(registry.find(hrps[i].data(), hrps[i].size()), i);
+    }
+    ASSERT_EQ(registry.find("hrp1000", 7), bech32::HrpRegistry::unknownHrp);
+}
+
+TEST(Bech32Test, decode_hrp_registry) {
+    bech32::HrpRegistry registry({"bc", "tb", "bcrt"});
+    std::vector<unsigned char> data = {0, 14, 20, 15, 7, 13, 26, 0, 25, 18, 6, 11, 13, 8, 21, 4};
+
+    bech32::DecodedIdResult b = bech32::decode(bech32::encode("tb", data), registry);
+    ASSERT_EQ(b.encoding, bech32::Encoding::Bech32m);
+    ASSERT_EQ(b.hrpId, 1);
+    ASSERT_EQ(b.dp, data);
+
+    b = bech32::decode("BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4", registry);
+    ASSERT_EQ(b.encoding, bech32::Encoding::Bech32);
+    ASSERT_EQ(b.hrpId, 0);
+    ASSERT_EQ(b.dp, bech32::decode("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4").dp);
+
+    // unregistered HRPs and bad checksums
+    b = bech32::decode(bech32::encode("ltc", data), registry);
+    ASSERT_EQ(b.encoding, bech32::Encoding::Invalid);
+    ASSERT_EQ(b.hrpId, bech32::HrpRegistry::unknownHrp);
+    ASSERT_TRUE(b.dp.empty());
+    b = bech32::decode("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t5", registry);
+    ASSERT_EQ(b.encoding, bech32::Encoding::Invalid);
+    ASSERT_EQ(b.hrpId, bech32::HrpRegistry::unknownHrp);
+    ASSERT_TRUE(b.dp.empty());
+    ASSERT_THROW(bech32::decode("bc1 not a valid string", registry), std::runtime_error);
+}
+
+TEST(Bech32Test, decode_dirty) {
+    std::string bstr = " example1:qpz!r--y9#x8&%&%ge-8-sqgv ";
+    bech32::DecodedResult b = bech32::decodeDirty(bstr);
+    bech32::DecodedResult c = bech32::decode(bech32::stripUnknownChars(bstr));
+    ASSERT_EQ(b.encoding, bech32::Encoding::Bech32m);
+    ASSERT_EQ(b.hrp, "example");
+    ASSERT_EQ(b.hrp, c.hrp);
+    ASSERT_EQ(b.dp, c.dp);
+
+    // separators in the HRP are kept
+    std::string clean = bech32::encode("1a1", {1, 2, 3});
+    b = bech32::decodeDirty("\t1 - a - " + clean.substr(2) + "\n");
+    ASSERT_EQ(b.encoding, bech32::Encoding::Bech32m);
+    ASSERT_EQ(b.hrp, "1a1");
+    ASSERT_EQ(b.dp, std::vector<unsigned char>({1, 2, 3}));
+
+    ASSERT_THROW(bech32::decodeDirty("a1 lqf ~ n"), std::runtime_error);
+    ASSERT_THROW(bech32::decodeDirty("A1 lqfn3a"), std::runtime_error);
+    ASSERT_THROW(bech32::decodeDirty("a lqfn3a xyz"), std::runtime_error);
+    ASSERT_THROW(bech32::decodeDirty(" 1 lqfn3a"), std::runtime_error);
+    ASSERT_EQ(bech32::decodeDirty("a1 lqfn3q").encoding, bech32::Encoding::Invalid);
+}
+
+// returns the result of f, or the message of the exception it throws
+template<typename F>
+std::string resultOrMessage(F f) {
+    try {
+        bech32::DecodedResult b = f();
+        return std::to_string(b.encoding) + b.hrp + std::string(b.dp.begin(), b.dp.end());
+    }
+    catch (std::runtime_error &e) {
+        return std::string("exception: ") + e.what();
+    }
+}
+
+RC_GTEST_PROP(Bech32TestRC, decodeDirtyShouldMatchStripThenDecode, ()
+) {
+    const auto hrp = *rc::gen::nonEmpty(
+            rc::gen::container<std::string>(
+                    rc::gen::oneOf(
+                            rc::gen::inRange('a', 'z'),
+                            rc::gen::inRange('0', '9'))));
+    const auto data =
+            *rc::gen::container<std::vector<unsigned char>>(
+                    *rc::gen::inRange<size_t>(0, 100),
+                    rc::gen::inRange<unsigned char>(0, 31));
+    std::string bstr = bech32::encode<bech32::UnlimitedLength>(hrp, data);
+    if (*rc::gen::arbitrary<bool>())
+        std::transform(bstr.begin(), bstr.end(), bstr.begin(), ::toupper);
+
+    // insert stray chars, which sometimes are (or change the case of) valid chars
+    const auto strays = *rc::gen::container<std::vector<std::pair<size_t, char>>>(
+            rc::gen::pair(rc::gen::inRange<size_t>(0, bstr.size() + 1), rc::gen::arbitrary<char>()));
+    for (const auto &stray : strays)
+        bstr.insert(std::min(stray.first, bstr.size()), 1, stray.second);
+
+    RC_ASSERT(resultOrMessage([&] { return bech32::decodeDirty(bstr); }) ==
+              resultOrMessage([&] { return bech32::decode(bech32::stripUnknownChars(bstr)); }));
+    RC_ASSERT(resultOrMessage([&] { return bech32::decodeDirty(bstr, bech32::limits::UNLIMITED_LENGTH); }) ==
+              resultOrMessage([&] { return bech32::decode(bech32::stripUnknownChars(bstr),
+                                                          bech32::limits::UNLIMITED_LENGTH); }));
+}
+
+TEST(Bech32Test, is_valid) {
+    ASSERT_TRUE(bech32::isValid("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4"));
+    ASSERT_TRUE(bech32::isValid("BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4"));
+    ASSERT_TRUE(bech32::isValid("a1lqfn3a"));
+    ASSERT_FALSE(bech32::isValid("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t5"));
+    ASSERT_FALSE(bech32::isValid("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7Kv8f3t4"));
+    ASSERT_FALSE(bech32::isValid("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7bv8f3t4"));
+    ASSERT_FALSE(bech32::isValid("1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4"));
+    ASSERT_FALSE(bech32::isValid("a1lqfn"));
+    ASSERT_FALSE(bech32::isValid(""));
+    ASSERT_FALSE(bech32::isValid(bolt11Invoice));
+    ASSERT_TRUE(bech32::isValid(bolt11Invoice, bech32::limits::UNLIMITED_LENGTH));
+}
+
+TEST(Bech32Test, detect_encoding) {
+    ASSERT_EQ(bech32::detectEncoding("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4"), bech32::Encoding::Bech32);
+    ASSERT_EQ(bech32::detectEncoding("a1lqfn3a"), bech32::Encoding::Bech32m);
+    ASSERT_EQ(bech32::detectEncoding("a12uel5l"), bech32::Encoding::Bech32);
+    ASSERT_EQ(bech32::detectEncoding("a12uel5m"), bech32::Encoding::Invalid);
+    ASSERT_EQ(bech32::detectEncoding("a 12uel5l"), bech32::Encoding::Invalid);
+}
+
+// returns the encoding decode() finds, or Invalid if it throws
+bech32::Encoding encodingFromDecode(const std::string &bstr, const bech32::LengthLimits &lengthLimits) {
+    try {
+        return bech32::decode(bstr, lengthLimits).encoding;
+    }
+    catch (std::runtime_error &) {
+        return bech32::Encoding::Invalid;
+    }
+}
+
+RC_GTEST_PROP(Bech32TestRC, detectEncodingShouldMatchDecode, ()
+) {
+    const auto hrp = *rc::gen::nonEmpty(
+            rc::gen::container<std::string>(
+                    rc::gen::inRange<char>(33, 126)));
+    const auto data =
+            *rc::gen::container<std::vector<unsigned char>>(
+                    *rc::gen::inRange<size_t>(0, 100),
+                    rc::gen::inRange<unsigned char>(0, 31));
+    std::string bstr = *rc::gen::arbitrary<bool>() ?
+            bech32::encode<bech32::UnlimitedLength>(hrp, data) :
+            bech32::encodeUsingOriginalConstant<bech32::UnlimitedLength>(hrp, data);
+
+    // sometimes change a char, which may break the string in any of the ways decode() checks
+    if (*rc::gen::arbitrary<bool>()) {
+        size_t i = *rc::gen::inRange<size_t>(0, bstr.size());
+        bstr[i] = *rc::gen::arbitrary<char>();
+    }
+
+    RC_ASSERT(bech32::detectEncoding(bstr) == encodingFromDecode(bstr, bech32::limits::STANDARD_LENGTH));
+    RC_ASSERT(bech32::detectEncoding(bstr, bech32::limits::UNLIMITED_LENGTH) ==
+              encodingFromDecode(bstr, bech32::limits::UNLIMITED_LENGTH));
+    RC_ASSERT(bech32::isValid(bstr) == (encodingFromDecode(bstr, bech32::limits::STANDARD_LENGTH) != bech32::Encoding::Invalid));
+}
+
+TEST(Bech32Test, decode_view) {
+    std::string bstr("BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4");
+    bech32::DecodedView view = bech32::decodeView(bstr);
+    bech32::DecodedResult expected = bech32::decode(bstr);
+    ASSERT_EQ(view.encoding(), bech32::Encoding::Bech32);
+    ASSERT_EQ(view.hrpData(), bstr.data());
+    ASSERT_EQ(view.hrpLength(), 2);
+    ASSERT_EQ(view.hrp(), "bc");
+    ASSERT_EQ(view.size(), expected.dp.size());
+    ASSERT_EQ(view[0], 0);
+    ASSERT_EQ(view.dp(), expected.dp);
+    ASSERT_EQ(std::vector<unsigned char>(view.begin(), view.end()), expected.dp);
+    ASSERT_EQ(view.end() - view.begin(), static_cast<std::ptrdiff_t>(view.size()));
+
+    view = bech32::decodeView("a1lqfn3a", 8);
+    ASSERT_EQ(view.encoding(), bech32::Encoding::Bech32m);
+    ASSERT_EQ(view.hrp(), "a");
+    ASSERT_TRUE(view.empty());
+    ASSERT_TRUE(view.begin() == view.end());
+}
+
+TEST(Bech32Test, decode_view_bad) {
+    const char *bad[] = {
+            "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t5",
+            "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7Kv8f3t4",
+            "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7bv8f3t4",
+            "1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4",
+            "a1lqfn",
+            ""
+    };
+    for (const char *bstr : bad) {
+        bech32::DecodedView view = bech32::decodeView(bstr, std::strlen(bstr));
+        ASSERT_EQ(view.encoding(), bech32::Encoding::Invalid);
+        ASSERT_EQ(view.hrpLength(), 0);
+        ASSERT_TRUE(view.empty());
+    }
+    std::string invoice(bolt11Invoice);
+    ASSERT_EQ(bech32::decodeView(invoice).encoding(), bech32::Encoding::Invalid);
+    ASSERT_EQ(bech32::decodeView(invoice, bech32::limits::UNLIMITED_LENGTH).dp(),
+              bech32::decode(invoice, bech32::limits::UNLIMITED_LENGTH).dp);
+}
+
+TEST(Bech32Test, packed_data) {
+    std::vector<unsigned char> values = {31, 0, 1, 2, 3, 30, 29, 28, 27, 0, 31};
+    bech32::PackedData packed(values);
+    ASSERT_EQ(packed.size(), values.size());
+    // 11 values take 55 bits, plus a byte of padding
+    ASSERT_EQ(packed.packedBytes().size(), 8);
+    for (size_t i = 0; i < values.size(); ++i)
+        ASSERT_EQ(packed[i], values[i]);
+    ASSERT_EQ(packed.unpack(), values);
+    ASSERT_EQ(packed.packedBytes()[0], 0xf8);
+
+    unsigned char out[4];
+    packed.unpack(7, 4, out);
+    ASSERT_EQ(std::vector<unsigned char>(out, out + 4), std::vector<unsigned char>(values.begin() + 7, values.end()));
+
+    bech32::PackedData pushed;
+    ASSERT_TRUE(pushed.empty());
+    for (unsigned char v : values)
+        pushed.push_back(v);
+    ASSERT_EQ(pushed, packed);
+    pushed.push_back(0);
+    ASSERT_NE(pushed, packed);
+    pushed.clear();
+    ASSERT_EQ(pushed, bech32::PackedData());
+
+    ASSERT_THROW(pushed.push_back(32), std::runtime_error);
+    ASSERT_THROW(bech32::PackedData({1, 2, 32}), std::runtime_error);
+}
+
+TEST(Bech32Test, decode_packed) {
+    std::string bstr("BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4");
+    bech32::DecodedResult expected = bech32::decode(bstr);
+    bech32::DecodedPackedResult packed = bech32::decodePacked(bstr);
+    ASSERT_EQ(packed.encoding, bech32::Encoding::Bech32);
+    ASSERT_EQ(packed.hrp, "bc");
+    ASSERT_EQ(packed.dp.unpack(), expected.dp);
+    ASSERT_EQ(bech32::encodePackedUsingOriginalConstant(packed.hrp, packed.dp), "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4");
+    ASSERT_EQ(bech32::encodePacked("a", bech32::PackedData()), "a1lqfn3a");
+
+    // errors are the same as for decode()
+    ASSERT_EQ(bech32::decodePacked("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t5").encoding, bech32::Encoding::Invalid);
+    ASSERT_THROW(bech32::decodePacked("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7Kv8f3t4"), std::runtime_error);
+    ASSERT_THROW(bech32::encodePacked("", bech32::PackedData()), std::runtime_error);
+    ASSERT_THROW(bech32::encodePacked("a", bech32::PackedData(std::vector<unsigned char>(90))), std::runtime_error);
+}
+
+RC_GTEST_PROP(Bech32TestRC, packedDataShouldMatchValues, (const std::vector<unsigned char> &input)
+) {
+    std::vector<unsigned char> values;
+    for (unsigned char c : input)
+        values.push_back(c & 31u);
+    bech32::PackedData packed(values);
+    RC_ASSERT(packed.size() == values.size());
+    RC_ASSERT(packed.unpack() == values);
+    for (size_t i = 0; i < values.size(); ++i)
+        RC_ASSERT(packed[i] == values[i]);
+
+    // appending in pieces gives the same bytes
+    size_t split = *rc::gen::inRange<size_t>(0, values.size() + 1);
+    bech32::PackedData pieces;
+    pieces.append(values.data(), values.data() + split);
+    pieces.append(values.data() + split, values.data() + values.size());
+    RC_ASSERT(pieces == packed);
+
+    size_t pos = *rc::gen::inRange<size_t>(0, values.size() + 1);
+    size_t n = *rc::gen::inRange<size_t>(0, values.size() - pos + 1);
+    std::vector<unsigned char> out(n);
+    packed.unpack(pos, n, out.data());
+    RC_ASSERT(out == std::vector<unsigned char>(values.begin() + pos, values.begin() + pos + n));
+}
+
+RC_GTEST_PROP(Bech32TestRC, packedEncodeAndDecodeShouldMatchUnpacked, ()
+) {
+    const auto hrp = *rc::gen::nonEmpty(
+            rc::gen::container<std::string>(
+                    rc::gen::inRange<char>(33, 126)));
+    const auto data =
+            *rc::gen::container<std::vector<unsigned char>>(
+                    *rc::gen::inRange<size_t>(0, 5000),
+                    rc::gen::inRange<unsigned char>(0, 31));
+    bech32::PackedData packed(data);
+    std::string bstr = bech32::encode(hrp, data, bech32::limits::UNLIMITED_LENGTH);
+    RC_ASSERT(bech32::encodePacked(hrp, packed, bech32::limits::UNLIMITED_LENGTH) == bstr);
+    RC_ASSERT(bech32::encodePackedUsingOriginalConstant(hrp, packed, bech32::limits::UNLIMITED_LENGTH) ==
+              bech32::encodeUsingOriginalConstant(hrp, data, bech32::limits::UNLIMITED_LENGTH));
+
+    bech32::DecodedResult expected = bech32::decode(bstr, bech32::limits::UNLIMITED_LENGTH);
+    bech32::DecodedPackedResult result = bech32::decodePacked(bstr, bech32::limits::UNLIMITED_LENGTH);
+    RC_ASSERT(result.encoding == expected.encoding);
+    RC_ASSERT(result.hrp == expected.hrp);
+    RC_ASSERT(result.dp == packed);
+}
+
+TEST(Bech32Test, decoded_result_equality_and_hash) {
+    bech32::DecodedResult a = bech32::decode("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4");
+    bech32::DecodedResult b = bech32::decode("BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4");
+    ASSERT_TRUE(a == b);
+    ASSERT_EQ(std::hash<bech32::DecodedResult>()(a), std::hash<bech32::DecodedResult>()(b));
+    b.encoding = bech32::Encoding::Bech32m;
+    ASSERT_TRUE(a != b);
+    ASSERT_NE(bech32::payloadHash(a), bech32::payloadHash(b));
+
+    std::unordered_set<bech32::DecodedResult> set;
+    set.insert(a);
+    set.insert(bech32::decode("BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4"));
+    set.insert(b);
+    ASSERT_EQ(set.size(), 2);
+}
+
+TEST(Bech32Test, canonical_hash) {
+    std::string lower("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4");
+    std::string upper("BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4");
+    std::string mixed("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7KV8F3T4");
+    ASSERT_EQ(bech32::canonicalHash(lower), bech32::canonicalHash(upper));
+    ASSERT_EQ(bech32::canonicalHash(lower), bech32::payloadHash(bech32::decode(lower)));
+    ASSERT_NE(bech32::canonicalHash(lower), bech32::canonicalHash(mixed));
+
+    bech32::CanonicalEqual equal;
+    ASSERT_TRUE(equal(lower, upper));
+    ASSERT_TRUE(equal(mixed, mixed));
+    ASSERT_FALSE(equal(lower, mixed));
+    ASSERT_FALSE(equal("a1lqfn3a", "a12uel5l"));
+
+    std::unordered_map<std::string, int, bech32::CanonicalHash, bech32::CanonicalEqual> map;
+    map[lower] = 1;
+    map[upper] = 2;
+    map[mixed] = 3;
+    ASSERT_EQ(map.size(), 2);
+    ASSERT_EQ(map[lower], 2);
+
+    std::string invoice(bolt11Invoice);
+    bech32::CanonicalHash unlimitedHash(bech32::limits::UNLIMITED_LENGTH);
+    ASSERT_EQ(unlimitedHash(invoice),
+              static_cast<size_t>(bech32::payloadHash(bech32::decode(invoice, bech32::limits::UNLIMITED_LENGTH))));
+}
+
+RC_GTEST_PROP(Bech32TestRC, canonicalHashShouldMatchPayloadHash, ()
+) {
+    const auto hrp = *rc::gen::nonEmpty(
+            rc::gen::container<std::string>(
+                    rc::gen::inRange<char>(33, 126)));
+    const auto data =
+            *rc::gen::container<std::vector<unsigned char>>(
+                    *rc::gen::inRange<size_t>(0, 100),
+                    rc::gen::inRange<unsigned char>(0, 31));
+    std::string bstr = *rc::gen::arbitrary<bool>() ?
+            bech32::encode<bech32::UnlimitedLength>(hrp, data) :
+            bech32::encodeUsingOriginalConstant<bech32::UnlimitedLength>(hrp, data);
+    bech32::DecodedResult decoded = bech32::decode(bstr, bech32::limits::UNLIMITED_LENGTH);
+    std::string upper(bstr);
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+
+    RC_ASSERT(bech32::canonicalHash(bstr, bech32::limits::UNLIMITED_LENGTH) == bech32::payloadHash(decoded));
+    RC_ASSERT(bech32::canonicalHash(upper, bech32::limits::UNLIMITED_LENGTH) == bech32::payloadHash(decoded));
+    RC_ASSERT(bech32::CanonicalEqual(bech32::limits::UNLIMITED_LENGTH)(bstr, upper));
+}
+
+// canonical forms of strings, the slow way
+std::set<std::string> referenceCanonical(const std::vector<std::string> &bstrings, bool segwitEncoding) {
+    std::set<std::string> ret;
+    for (const std::string &bstr : bstrings) {
+        bech32::DecodedResult decoded;
+        try {
+            decoded = bech32::decode(bstr);
+        }
+        catch (std::runtime_error &) {
+            continue;
+        }
+        if (decoded.encoding == bech32::Encoding::Invalid)
+            continue;
+        if (segwitEncoding && !decoded.dp.empty() && decoded.dp[0] <= 16)
+            decoded.encoding = decoded.dp[0] == 0 ? bech32::Encoding::Bech32 : bech32::Encoding::Bech32m;
+        ret.insert(decoded.encoding == bech32::Encoding::Bech32m ?
+                   bech32::encode(decoded.hrp, decoded.dp) :
+                   bech32::encodeUsingOriginalConstant(decoded.hrp, decoded.dp));
+    }
+    return ret;
+}
+
+// random segwit-like strings, with some duplicates in upper case and some broken
+std::vector<std::string> randomAddressStrings(size_t n) {
+    std::mt19937 rng(static_cast<std::mt19937::result_type>(n));
+    std::uniform_int_distribution<int> value(0, 31);
+    std::vector<std::string> ret;
+    for (size_t i = 0; i < n; ++i) {
+        if (i % 5 == 4) {
+            std::string dup = ret[rng() % ret.size()];
+            std::transform(dup.begin(), dup.end(), dup.begin(), ::toupper);
+            ret.push_back(dup);
+            continue;
+        }
+        std::vector<unsigned char> dp(i % 3 ? 33 : 53);
+        for (size_t j = 1; j < dp.size(); ++j)
+            dp[j] = static_cast<unsigned char>(value(rng) % (i % 7 ? 32 : 2));
+        dp[0] = static_cast<unsigned char>(i % 3 ? 0 : 1);
+        std::string hrp = i % 11 ? "bc" : "tb";
+        ret.push_back(i % 2 ? bech32::encode(hrp, dp) : bech32::encodeUsingOriginalConstant(hrp, dp));
+        if (i % 13 == 0)
+            ret.back()[10] = ret.back()[10] == 'q' ? 'p' : 'q';
+    }
+    return ret;
+}
+
+std::vector<std::string> deduplicate(const std::vector<std::string> &bstrings, const bech32::CanonicalizeOptions &options) {
+    bech32::AddressDeduplicator deduplicator(options);
+    for (const std::string &bstr : bstrings)
+        deduplicator.add(bstr);
+    std::vector<std::string> ret;
+    deduplicator.finish([&ret](const std::string &bstr) { ret.push_back(bstr); });
+    return ret;
+}
+
+TEST(Bech32Test, canonicalize_addresses) {
+    std::stringstream in;
+    in << "BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4\n"
+       << "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4\r\n"
+       << "\n"
+       << "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t5\n"
+       << "a1lqfn3a\n"
+       << "A12UEL5L\n";
+    std::stringstream out;
+    bech32::CanonicalizeStats stats = bech32::canonicalizeAddresses(in, out);
+    ASSERT_EQ(stats.lines, 5);
+    ASSERT_EQ(stats.invalid, 1);
+    ASSERT_EQ(stats.unique, 3);
+    ASSERT_EQ(out.str(), "a12uel5l\na1lqfn3a\nbc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4\n");
+
+    // a witness version 0 program encoded with bech32m is normalized to bech32
+    bech32::DecodedResult v0 = bech32::decode("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4");
+    bech32::CanonicalizeOptions options;
+    options.segwitEncoding = true;
+    ASSERT_EQ(deduplicate({bech32::encode("bc", v0.dp), "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4"}, options),
+              std::vector<std::string>({"bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4"}));
+
+    // groups are found ignoring case, and forgotten by finish()
+    bech32::AddressDeduplicator deduplicator(options);
+    for (int pass = 0; pass < 2; ++pass) {
+        deduplicator.add("A12UEL5L");
+        deduplicator.add("BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4");
+        deduplicator.add("a12uel5l");
+        std::vector<std::string> found;
+        ASSERT_EQ(deduplicator.finish([&found](const std::string &bstr) { found.push_back(bstr); }), 2);
+        ASSERT_EQ(found, std::vector<std::string>({"a12uel5l", "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4"}));
+    }
+}
+
+TEST(Bech32Test, canonicalize_addresses_spilled_and_parallel) {
+    std::vector<std::string> bstrings = randomAddressStrings(2000);
+    for (bool segwitEncoding : {false, true}) {
+        std::set<std::string> expected = referenceCanonical(bstrings, segwitEncoding);
+        bech32::CanonicalizeOptions options;
+        options.segwitEncoding = segwitEncoding;
+        options.threads = 1;
+        std::vector<std::string> inMemory = deduplicate(bstrings, options);
+        ASSERT_EQ(std::set<std::string>(inMemory.begin(), inMemory.end()), expected);
+        ASSERT_EQ(inMemory.size(), expected.size());
+
+        // many small runs spilled to temporary files
+        options.memoryLimit = 1000;
+        ASSERT_EQ(deduplicate(bstrings, options), inMemory);
+    }
+
+    // enough keys in one group to sort on several threads
+    std::mt19937 rng(1);
+    bstrings.clear();
+    for (size_t i = 0; i < 80000; ++i) {
+        std::vector<unsigned char> dp(33);
+        for (unsigned char &v : dp)
+            v = static_cast<unsigned char>(rng() % 32);
+        dp[0] = 0;
+        bstrings.push_back(i % 4 == 3 ? bstrings[rng() % bstrings.size()] : bech32::encodeUsingOriginalConstant("bc", dp));
+    }
+    bech32::CanonicalizeOptions options;
+    options.threads = 1;
+    std::vector<std::string> serial = deduplicate(bstrings, options);
+    options.threads = 4;
+    ASSERT_EQ(deduplicate(bstrings, options), serial);
+    std::set<std::string> expected = referenceCanonical(bstrings, false);
+    ASSERT_EQ(std::set<std::string>(serial.begin(), serial.end()), expected);
+}
+
+TEST(Bech32Test, checksum_state) {
+    std::vector<unsigned char> dp = {0, 14, 20, 15, 7, 13, 26, 0, 25, 18, 6, 11, 13, 8, 21, 4, 20, 3, 17, 2, 29, 3, 12, 29,
+                                     3, 4, 15, 24, 20, 6, 14, 30, 22};
+    bech32::ChecksumState state("BC");
+    state.update(std::vector<unsigned char>(dp.begin(), dp.begin() + 10));
+    bech32::ChecksumState prefix = state.clone();
+    state.update(dp[10]);
+    state.update(std::vector<unsigned char>(dp.begin() + 11, dp.end()));
+    ASSERT_EQ(state.size(), dp.size());
+    ASSERT_EQ(state.finalize(bech32::Encoding::Bech32), createChecksumUsingOriginalConstant("bc", dp));
+    ASSERT_EQ(state.finalize(), createChecksum("bc", dp));
+    ASSERT_THROW(state.finalize(bech32::Encoding::Invalid), std::runtime_error);
+
+    // feeding the checksum itself gives a valid residue
+    bech32::ChecksumState whole = state.clone();
+    whole.update(state.finalize(bech32::Encoding::Bech32));
+    ASSERT_EQ(whole.verify(), bech32::Encoding::Bech32);
+    ASSERT_EQ(state.verify(), bech32::Encoding::Invalid);
+
+    // the clone is unaffected by later updates
+    ASSERT_EQ(prefix.size(), 10);
+    ASSERT_EQ(prefix.finalize(), createChecksum("bc", std::vector<unsigned char>(dp.begin(), dp.begin() + 10)));
+
+    ASSERT_THROW(bech32::ChecksumState(""), std::runtime_error);
+    ASSERT_THROW(bech32::ChecksumState("a b"), std::runtime_error);
+    ASSERT_THROW(state.update(32), std::runtime_error);
+    ASSERT_EQ(state.size(), dp.size());
+    ASSERT_EQ(state.finalize(), createChecksum("bc", dp));
+}
+
+RC_GTEST_PROP(Bech32TestRC, checksumStateChunksShouldMatchCreateChecksum, ()
+) {
+    const auto hrp = *rc::gen::nonEmpty(rc::gen::container<std::string>(rc::gen::inRange<char>('a', 'z' + 1)));
+    const auto dp = *rc::gen::container<std::vector<unsigned char>>(rc::gen::inRange<unsigned char>(0, 32));
+    const auto cuts = *rc::gen::container<std::vector<size_t>>(rc::gen::inRange<size_t>(0, dp.size() + 1));
+
+    std::vector<size_t> bounds(cuts);
+    bounds.push_back(0);
+    bounds.push_back(dp.size());
+    std::sort(bounds.begin(), bounds.end());
+    bech32::ChecksumState state(hrp);
+    for (size_t i = 0; i + 1 < bounds.size(); ++i)
+        state.update(dp.data() + bounds[i], dp.data() + bounds[i + 1]);
+
+    RC_ASSERT(state.size() == dp.size());
+    RC_ASSERT(state.finalize() == createChecksum(hrp, dp));
+    RC_ASSERT(state.finalize(bech32::Encoding::Bech32) == createChecksumUsingOriginalConstant(hrp, dp));
+}
+
+TEST(Bech32Test, encode_to) {
+    std::vector<unsigned char> dp = {14, 15, 3, 31, 13};
+    std::string out = "addresses: ";
+    bech32::encodeTo(out, "hello", dp);
+    out += ", ";
+    bech32::encodeTo(out, "HELLO", dp, bech32::Encoding::Bech32);
+    ASSERT_EQ(out, "addresses: " + bech32::encode("hello", dp) + ", " +
+                   bech32::encodeUsingOriginalConstant("hello", dp));
+
+    std::string upper;
+    bech32::encodeTo(upper, "hello", dp, bech32::Encoding::Bech32m, bech32::Uppercase);
+    ASSERT_EQ(upper, "HELLO1W0RLDJN365X");
+    ASSERT_EQ(bech32::decode(upper), bech32::decode(bech32::encode("hello", dp)));
+
+    // output iterators, with long strings written over several blocks
+    std::vector<unsigned char> longDp(1000, 7);
+    std::vector<char> chars;
+    bech32::encodeTo(std::back_inserter(chars), "hello", longDp, bech32::Encoding::Bech32m, bech32::Lowercase,
+                     bech32::limits::UNLIMITED_LENGTH);
+    ASSERT_EQ(std::string(chars.begin(), chars.end()),
+              bech32::encode("hello", longDp, bech32::limits::UNLIMITED_LENGTH));
+    std::ostringstream stream;
+    bech32::encodeTo(std::ostream_iterator<char>(stream), "hello", longDp, bech32::Encoding::Bech32,
+                     bech32::Uppercase, bech32::limits::UNLIMITED_LENGTH);
+    std::string expected = bech32::encodeUsingOriginalConstant("hello", longDp, bech32::limits::UNLIMITED_LENGTH);
+    std::transform(expected.begin(), expected.end(), expected.begin(), ::toupper);
+    ASSERT_EQ(stream.str(), expected);
+
+    // out is unchanged when encoding fails
+    std::string unchanged = "x";
+    ASSERT_THROW(bech32::encodeTo(unchanged, "", dp), std::runtime_error);
+    ASSERT_THROW(bech32::encodeTo(unchanged, "hello", {32}), std::runtime_error);
+    ASSERT_THROW(bech32::encodeTo(unchanged, "hello", longDp), std::runtime_error);
+    ASSERT_THROW(bech32::encodeTo(unchanged, "hello", dp, bech32::Encoding::Invalid), std::runtime_error);
+    ASSERT_EQ(unchanged, "x");
+}
+
+RC_GTEST_PROP(Bech32TestRC, encodeToShouldMatchEncode, ()
+) {
+    const auto hrp = *rc::gen::nonEmpty(rc::gen::container<std::string>(rc::gen::inRange<char>('a', 'z' + 1)));
+    const auto dp = *rc::gen::container<std::vector<unsigned char>>(rc::gen::inRange<unsigned char>(0, 32));
+    const auto prefix = *rc::gen::arbitrary<std::string>();
+
+    std::string out = prefix;
+    bech32::encodeTo(out, hrp, dp, bech32::Encoding::Bech32m, bech32::Lowercase, bech32::limits::UNLIMITED_LENGTH);
+    RC_ASSERT(out == prefix + bech32::encode(hrp, dp, bech32::limits::UNLIMITED_LENGTH));
+
+    std::string chars;
+    bech32::encodeTo(std::back_inserter(chars), hrp, dp, bech32::Encoding::Bech32, bech32::Lowercase,
+                     bech32::limits::UNLIMITED_LENGTH);
+    RC_ASSERT(chars == bech32::encodeUsingOriginalConstant(hrp, dp, bech32::limits::UNLIMITED_LENGTH));
+}
+
+namespace {
+
+    // decode a string as a StreamDecoder reports it, with an Invalid encoding where decode()
+    // would throw
+    bech32::DecodedResult decodeOrInvalid(const std::string &bstr, const bech32::LengthLimits &lengthLimits) {
+        try {
+            return bech32::decode(bstr, lengthLimits);
+        } catch (const std::runtime_error &) {
+            return bech32::DecodedResult{bech32::Encoding::Invalid, "", {}};
+        }
+    }
+
+}
+
+TEST(Bech32Test, stream_decoder) {
+    std::vector<std::pair<std::string, bech32::DecodedResult>> reported;
+    bech32::StreamDecoder decoder([&](const std::string &bstr, const bech32::DecodedResult &decoded) {
+        reported.emplace_back(bstr, decoded);
+    });
+
+    std::string stream = "BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4\r\n"
+                         "tb1qrp33g0q5c5txsp9arysrx4k6zdkfs4nce4xj0gdcccefvpysxf3q0sl5k7,,"
+                         "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t5 "
+                         "1pzry9x0s0muk x1y1z1qqqqqqqq\n"
+                         "a12uel5l";
+    // one char at a time, so that every string is split across chunks
+    for (char c : stream) {
+        decoder.push(&c, 1);
+    }
+    ASSERT_EQ(decoder.count(), 5);
+    decoder.finish();
+    ASSERT_EQ(decoder.count(), 6);
+
+    std::vector<std::string> expected = {
+            "BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4",
+            "tb1qrp33g0q5c5txsp9arysrx4k6zdkfs4nce4xj0gdcccefvpysxf3q0sl5k7",
+            "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t5",
+            "1pzry9x0s0muk",
+            "x1y1z1qqqqqqqq",
+            "a12uel5l"};
+    ASSERT_EQ(reported.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_EQ(reported[i].first, expected[i]);
+        ASSERT_EQ(reported[i].second, decodeOrInvalid(expected[i], bech32::limits::STANDARD_LENGTH));
+    }
+    ASSERT_EQ(reported[0].second.encoding, bech32::Encoding::Bech32);
+    ASSERT_EQ(reported[1].second.encoding, bech32::Encoding::Bech32);
+    ASSERT_EQ(reported[2].second.encoding, bech32::Encoding::Invalid);
+    ASSERT_EQ(reported[5].second.encoding, bech32::Encoding::Bech32);
+
+    // strings past the length limits are cut short, and the next string is unaffected
+    reported.clear();
+    decoder.push(std::string(100, 'q') + " a12uel5l ");
+    decoder.finish();
+    ASSERT_EQ(reported.size(), 2);
+    ASSERT_EQ(reported[0].first, std::string(90, 'q'));
+    ASSERT_EQ(reported[0].second.encoding, bech32::Encoding::Invalid);
+    ASSERT_EQ(reported[1].second, bech32::decode("a12uel5l"));
+}
+
+RC_GTEST_PROP(Bech32TestRC, streamDecoderShouldMatchDecode, ()
+) {
+    const auto hrps = std::vector<std::string>({"bc", "a", "B1C", "x1y"});
+    const auto count = *rc::gen::inRange<size_t>(0, 20);
+    std::vector<std::string> bstrings;
+    for (size_t i = 0; i < count; ++i) {
+        std::string bstr = bech32::encode(*rc::gen::elementOf(hrps),
+                                          *rc::gen::container<std::vector<unsigned char>>(
+                                                  rc::gen::inRange<unsigned char>(0, 32)),
+                                          bech32::limits::UNLIMITED_LENGTH);
+        // sometimes damage a char, or append junk
+        if (*rc::gen::inRange(0, 4) == 0)
+            bstr[*rc::gen::inRange<size_t>(0, bstr.size())] = *rc::gen::element('q', 'Q', '1', 'b', '!');
+        // (past ',', which is a delimiter)
+        if (*rc::gen::inRange(0, 8) == 0)
+            bstr += *rc::gen::nonEmpty(rc::gen::container<std::string>(rc::gen::inRange<char>('-', '~' + 1)));
+        if (*rc::gen::inRange(0, 8) == 0)
+            std::transform(bstr.begin(), bstr.end(), bstr.begin(), ::toupper);
+        bstrings.push_back(bstr);
+    }
+    bech32::LengthLimits lengthLimits = {20, 60};
+
+    std::string stream;
+    for (const std::string &bstr : bstrings)
+        stream += bstr + *rc::gen::element<std::string>(" ", "\n", ",", "\r\n", "  ");
+
+    std::vector<std::string> reported;
+    std::vector<bech32::DecodedResult> results;
+    bech32::StreamDecoder decoder([&](const std::string &bstr, const bech32::DecodedResult &decoded) {
+        reported.push_back(bstr);
+        results.push_back(decoded);
+    }, lengthLimits);
+    size_t pos = 0;
+    while (pos < stream.size()) {
+        size_t n = std::min(stream.size() - pos, *rc::gen::inRange<size_t>(1, 16));
+        decoder.push(stream.data() + pos, n);
+        pos += n;
+    }
+    decoder.finish();
+
+    RC_ASSERT(reported.size() == bstrings.size());
+    for (size_t i = 0; i < bstrings.size(); ++i) {
+        RC_ASSERT(reported[i] == bstrings[i].substr(0, lengthLimits.maxBech32Length));
+        RC_ASSERT(results[i] == decodeOrInvalid(bstrings[i], lengthLimits));
+    }
+}
+
+namespace {
+
+    // the strings in the layout of an Arrow string array
+    struct TestStringColumn {
+        explicit TestStringColumn(const std::vector<std::string> &strings) : offsets(1, 0) {
+            for (const std::string &s : strings) {
+                data += s;
+                offsets.push_back(static_cast<int32_t>(data.size()));
+            }
+        }
+
+        bech32::StringColumn column() const {
+            return bech32::StringColumn{offsets.data(), data.data(), offsets.size() - 1};
+        }
+
+        std::vector<int32_t> offsets;
+        std::string data;
+    };
+
+}
+
+TEST(Bech32Test, decode_column) {
+    std::vector<std::string> strings = {
+            "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4",
+            "",
+            "BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4",
+            "a12uel5l",
+            "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t5",
+            "tb1qrp33g0q5c5txsp9arysrx4k6zdkfs4nce4xj0gdcccefvpysxf3q0sl5k7",
+            "bc1p0xlxvlhemja6c4dqv22uapctqupfhlxm9h8z3k2e72q4k9hcz7vqzk5jj0",
+            "not an address",
+            "tb1qw508d6qejxtdg4y5r3zarvary0c5xw7kxpjzsx"};
+    TestStringColumn input(strings);
+    bech32::HrpRegistry registry({"bc", "tb"});
+
+    std::vector<uint8_t> validity(2, 0xff);
+    std::vector<uint8_t> encodings(strings.size());
+    std::vector<bech32::HrpId> hrpIds(strings.size());
+    std::vector<int32_t> dataLengths(strings.size());
+    std::vector<int32_t> dataOffsets(strings.size() + 1);
+    std::vector<unsigned char> data(input.data.size());
+    bech32::DecodedColumns out = {validity.data(), encodings.data(), hrpIds.data(), dataLengths.data(),
+                                  dataOffsets.data(), data.data()};
+    ASSERT_EQ(bech32::decodeColumn(input.column(), registry, out), 5);
+
+    // bits 0, 2, 5, 6 and 8; "a12uel5l" is valid but its HRP isn't registered
+    ASSERT_EQ(validity[0], 0x65);
+    ASSERT_EQ(validity[1], 0x01);
+    for (size_t i = 0; i < strings.size(); ++i) {
+        bool valid = (validity[i / 8] >> (i % 8)) & 1u;
+        bech32::DecodedIdResult expected = bech32::decode(strings[i], registry);
+        if (expected.encoding == bech32::Encoding::Invalid) {
+            ASSERT_FALSE(valid);
+            ASSERT_EQ(encodings[i], bech32::Encoding::Invalid);
+            ASSERT_EQ(hrpIds[i], bech32::HrpRegistry::unknownHrp);
+            ASSERT_EQ(dataLengths[i], 0);
+            ASSERT_EQ(dataOffsets[i + 1], dataOffsets[i]);
+            continue;
+        }
+        ASSERT_TRUE(valid);
+        ASSERT_EQ(encodings[i], expected.encoding);
+        ASSERT_EQ(hrpIds[i], expected.hrpId);
+        ASSERT_EQ(dataLengths[i], static_cast<int32_t>(expected.dp.size()));
+        bech32::PackedData packed(expected.dp);
+        std::vector<unsigned char> bytes = packed.packedBytes();
+        bytes.resize((5 * expected.dp.size() + 7) / 8);
+        ASSERT_EQ(std::vector<unsigned char>(data.begin() + dataOffsets[i], data.begin() + dataOffsets[i + 1]), bytes);
+    }
+
+    // columns can be skipped
+    out = {validity.data(), nullptr, nullptr, nullptr, nullptr, nullptr};
+    ASSERT_EQ(bech32::decodeColumn(input.column(), registry, out), 5);
+
+    std::vector<uint8_t> validEncodings(strings.size());
+    ASSERT_EQ(bech32::validateColumn(input.column(), validity.data(), validEncodings.data()), 6);
+    ASSERT_EQ(validity[0], 0x6d);
+    ASSERT_EQ(validEncodings[3], bech32::Encoding::Bech32);
+    ASSERT_EQ(validEncodings[6], bech32::Encoding::Bech32m);
+    ASSERT_EQ(validEncodings[4], bech32::Encoding::Invalid);
+
+    // a column may start part way into its buffers, as a slice does
+    bech32::StringColumn slice = {input.offsets.data() + 3, input.data.data(), 2};
+    ASSERT_EQ(bech32::validateColumn(slice, validity.data(), nullptr), 1);
+    ASSERT_EQ(validity[0], 0x01);
+
+    std::vector<int32_t> badOffsets = {0, 5, 3};
+    bech32::StringColumn bad = {badOffsets.data(), input.data.data(), 2};
+    ASSERT_THROW(bech32::validateColumn(bad, validity.data(), nullptr), std::runtime_error);
+}
+
+TEST(Bech32Test, base32) {
+    ASSERT_EQ(bech32::encodeBase32(std::vector<unsigned char>()), "");
+    ASSERT_EQ(bech32::encodeBase32(std::vector<unsigned char>({0x00})), "qq");
+    ASSERT_EQ(bech32::encodeBase32(std::vector<unsigned char>({0xff})), "lu");
+    ASSERT_EQ(bech32::encodeBase32(std::vector<unsigned char>({0x00, 0x44, 0x32, 0x14, 0xc7})), "qpzry9x8");
+    ASSERT_EQ(bech32::decodeBase32("QPZRY9X8"), std::vector<unsigned char>({0x00, 0x44, 0x32, 0x14, 0xc7}));
+    ASSERT_EQ(bech32::decodeBase32("lu"), std::vector<unsigned char>({0xff}));
+    ASSERT_TRUE(bech32::decodeBase32("").empty());
+
+    // bad chars, a dangling char and nonzero padding
+    ASSERT_THROW(bech32::decodeBase32("qpzry9x1"), std::runtime_error);
+    ASSERT_THROW(bech32::decodeBase32("qqq"), std::runtime_error);
+    ASSERT_THROW(bech32::decodeBase32("lp"), std::runtime_error);
+
+    // a bad char leaves the decoder's output as it was
+    bech32::Base32Decoder decoder;
+    std::vector<unsigned char> out = {0x01, 0x02};
+    ASSERT_THROW(decoder.update("qpzry9x8qpzry9x1", 16, out), std::runtime_error);
+    ASSERT_EQ(out, std::vector<unsigned char>({0x01, 0x02}));
+    // also in the chars that would be held back
+    ASSERT_THROW(decoder.update("qqqqqqqqqb", 10, out), std::runtime_error);
+    ASSERT_EQ(out, std::vector<unsigned char>({0x01, 0x02}));
+    // and with chars held back from before, which are kept
+    decoder.update("qqq", 3, out);
+    ASSERT_THROW(decoder.update("qqqqqqqqqqqqqb", 14, out), std::runtime_error);
+    ASSERT_THROW(decoder.update("qqqqqqqqqqqqqqqqqqqqqqqqqb", 26, out), std::runtime_error);
+    ASSERT_EQ(out, std::vector<unsigned char>({0x01, 0x02}));
+    decoder.update("qqqqq", 5, out);
+    decoder.finish(out);
+    ASSERT_EQ(out, std::vector<unsigned char>({0x01, 0x02, 0, 0, 0, 0, 0}));
+
+    // the same data part values as a bech32 string, for whole bytes
+    std::vector<unsigned char> data = {0x75, 0x1e, 0x76, 0xe8, 0x19, 0x91, 0x96, 0xd4, 0x54, 0x94,
+                                       0x1c, 0x45, 0xd1, 0xb3, 0xa3, 0x23, 0xf1, 0x43, 0x3b, 0xd6};
+    bech32::DecodedResult decoded = bech32::decode("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4");
+    std::string expected;
+    for (size_t i = 1; i < decoded.dp.size(); ++i)
+        expected += "qpzry9x8gf2tvdw0s3jn54khce6mua7l"[decoded.dp[i]];
+    ASSERT_EQ(bech32::encodeBase32(data), expected);
+}
+
+RC_GTEST_PROP(Bech32TestRC, base32ChunksShouldRoundTrip, ()
+) {
+    const auto data = *rc::gen::container<std::vector<unsigned char>>(rc::gen::arbitrary<unsigned char>());
+    std::string chars = bech32::encodeBase32(data);
+    RC_ASSERT(chars.size() == (8 * data.size() + 4) / 5);
+    RC_ASSERT(bech32::decodeBase32(chars) == data);
+
+    // the same, a chunk at a time
+    bech32::Base32Encoder encoder;
+    std::string streamed;
+    for (size_t pos = 0; pos < data.size();) {
+        size_t n = std::min(data.size() - pos, *rc::gen::inRange<size_t>(1, 20));
+        encoder.update(data.data() + pos, n, streamed);
+        pos += n;
+    }
+    encoder.finish(streamed);
+    RC_ASSERT(streamed == chars);
+
+    bech32::Base32Decoder decoder;
+    std::vector<unsigned char> decoded;
+    for (size_t pos = 0; pos < chars.size();) {
+        size_t n = std::min(chars.size() - pos, *rc::gen::inRange<size_t>(1, 20));
+        decoder.update(chars.data() + pos, n, decoded);
+        pos += n;
+    }
+    decoder.finish(decoded);
+    RC_ASSERT(decoded == data);
+}
+
+TEST(Bech32Test, decode_cache) {
+    bech32::DecodeCache cache(4, 2);
+    std::string bstr = "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4";
+    ASSERT_EQ(cache.decode(bstr), bech32::decode(bstr));
+    ASSERT_EQ(cache.decode(bstr), bech32::decode(bstr));
+    bech32::CacheStats stats = cache.stats();
+    ASSERT_EQ(stats.hits, 1);
+    ASSERT_EQ(stats.misses, 1);
+    ASSERT_EQ(stats.size, 1);
+
+    // results with a bad checksum are cached, errors aren't
+    std::string bad = "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t5";
+    ASSERT_EQ(cache.decode(bad).encoding, bech32::Encoding::Invalid);
+    ASSERT_EQ(cache.decode(bad).encoding, bech32::Encoding::Invalid);
+    ASSERT_THROW(cache.decode("a1"), std::runtime_error);
+    ASSERT_THROW(cache.decode("a1"), std::runtime_error);
+    stats = cache.stats();
+    ASSERT_EQ(stats.hits, 2);
+    ASSERT_EQ(stats.misses, 4);
+    ASSERT_EQ(stats.size, 2);
+
+    // the cache stays within its capacity, dropping the least recently used strings
+    for (int i = 0; i < 20; ++i)
+        cache.decode(bech32::encode("a", std::vector<unsigned char>(1, static_cast<unsigned char>(i))));
+    ASSERT_LE(cache.stats().size, 4);
+    ASSERT_EQ(cache.decode(bstr), bech32::decode(bstr));
+
+    cache.clear();
+    stats = cache.stats();
+    ASSERT_EQ(stats.hits, 0);
+    ASSERT_EQ(stats.misses, 0);
+    ASSERT_EQ(stats.size, 0);
+}
+
+TEST(Bech32Test, encode_cache) {
+    bech32::EncodeCache cache(16);
+    std::vector<unsigned char> dp = {1, 2, 3};
+    ASSERT_EQ(cache.encode("a", dp), bech32::encode("a", dp));
+    ASSERT_EQ(cache.encode("a", dp, bech32::Encoding::Bech32), bech32::encodeUsingOriginalConstant("a", dp));
+    ASSERT_EQ(cache.encode("a", dp), bech32::encode("a", dp));
+    bech32::CacheStats stats = cache.stats();
+    ASSERT_EQ(stats.hits, 1);
+    ASSERT_EQ(stats.misses, 2);
+    ASSERT_EQ(stats.size, 2);
+
+    ASSERT_THROW(cache.encode("a", dp, bech32::Encoding::Invalid), std::runtime_error);
+    ASSERT_THROW(cache.encode("", dp), std::runtime_error);
+    ASSERT_EQ(cache.stats().size, 2);
+}
+
+TEST(Bech32Test, decode_cache_threads) {
+    std::vector<std::string> bstrings;
+    for (int i = 0; i < 64; ++i)
+        bstrings.push_back(bech32::encode("bc", std::vector<unsigned char>(20, static_cast<unsigned char>(i % 32))));
+
+    bech32::DecodeCache cache(32, 4);
+    std::atomic<int> mismatches(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 2000; ++i) {
+                const std::string &bstr = bstrings[(i * 7 + t) % bstrings.size()];
+                if (cache.decode(bstr) != bech32::decode(bstr))
+                    ++mismatches;
+            }
+        });
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+
+    ASSERT_EQ(mismatches, 0);
+    bech32::CacheStats stats = cache.stats();
+    ASSERT_EQ(stats.hits + stats.misses, 8000);
+    ASSERT_GT(stats.hits, 0);
+    ASSERT_LE(stats.size, 32);
+}
+
+TEST(Bech32Test, address_set) {
+    bech32::AddressSet set;
+    ASSERT_TRUE(set.empty());
+    ASSERT_TRUE(set.insert("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4"));
+    ASSERT_FALSE(set.insert("BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4"));
+    ASSERT_FALSE(set.insert("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t5"));
+    ASSERT_TRUE(set.insert(bech32::decode("a1lqfn3a")));
+    ASSERT_FALSE(set.insert(bech32::decode("A1LQFN3A")));
+    ASSERT_EQ(set.size(), 2);
+
+    ASSERT_TRUE(set.contains("BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4"));
+    ASSERT_TRUE(set.contains(bech32::decode("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4")));
+    ASSERT_TRUE(set.contains("a1lqfn3a"));
+    // bad checksum, other data, other encoding and other HRP
+    ASSERT_FALSE(set.contains("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t5"));
+    ASSERT_FALSE(set.contains("bc1qr508d6qejxtdg4y5r3zarvary0c5xw7kw2vd5n"));
+    ASSERT_FALSE(set.contains("a12uel5l"));
+    ASSERT_FALSE(set.contains("tb1qw508d6qejxtdg4y5r3zarvary0c5xw7kxpjzsx"));
+    ASSERT_FALSE(set.contains("not an address"));
+    ASSERT_FALSE(set.contains(bech32::DecodedResult()));
+
+    ASSERT_THROW(set.insert(bech32::DecodedResult()), std::runtime_error);
+    ASSERT_THROW(set.insert(bech32::DecodedResult{bech32::Encoding::Bech32, "bc", {32}}), std::runtime_error);
+    ASSERT_GT(set.memoryUsage(), 0);
+
+    // empty data parts, from strings and from payloads
+    ASSERT_TRUE(set.insert("A12UEL5L"));
+    ASSERT_FALSE(set.insert(bech32::DecodedResult{bech32::Encoding::Bech32, "a", {}}));
+    ASSERT_TRUE(set.contains("a12uel5l"));
+    ASSERT_TRUE(set.contains(bech32::DecodedResult{bech32::Encoding::Bech32m, "A", {}}));
+    ASSERT_FALSE(set.contains(bech32::DecodedResult{bech32::Encoding::Bech32m, "b", {}}));
+    ASSERT_EQ(set.size(), 3);
+}
+
+RC_GTEST_PROP(Bech32TestRC, addressSetShouldMatchUnorderedSet, ()
+) {
+    const auto hrps = std::vector<std::string>({"bc", "tb", "a"});
+    const auto payloads = *rc::gen::container<std::vector<bech32::DecodedResult>>(
+            rc::gen::construct<bech32::DecodedResult>(
+                    rc::gen::element(bech32::Encoding::Bech32, bech32::Encoding::Bech32m),
+                    rc::gen::elementOf(hrps),
+                    rc::gen::container<std::vector<unsigned char>>(
+                            *rc::gen::inRange<size_t>(0, 3),
+                            rc::gen::inRange<unsigned char>(0, 4))));
+
+    bech32::AddressSet set;
+    std::unordered_set<bech32::DecodedResult> expected;
+    for (size_t i = 0; i < payloads.size(); ++i) {
+        const bech32::DecodedResult &payload = payloads[i];
+        if (i % 2)
+            RC_ASSERT(set.insert(payload) == expected.insert(payload).second);
+        else {
+            std::string bstr = payload.encoding == bech32::Encoding::Bech32m ?
+                    bech32::encode(payload.hrp, payload.dp) :
+                    bech32::encodeUsingOriginalConstant(payload.hrp, payload.dp);
+            RC_ASSERT(set.insert(bstr) == expected.insert(payload).second);
+        }
+    }
+    RC_ASSERT(set.size() == expected.size());
+    for (const bech32::DecodedResult &payload : payloads)
+        RC_ASSERT(set.contains(payload));
+
+    const auto other = *rc::gen::construct<bech32::DecodedResult>(
+            rc::gen::element(bech32::Encoding::Bech32, bech32::Encoding::Bech32m),
+            rc::gen::elementOf(hrps),
+            rc::gen::container<std::vector<unsigned char>>(
+                    *rc::gen::inRange<size_t>(0, 3),
+                    rc::gen::inRange<unsigned char>(0, 4)));
+    RC_ASSERT(set.contains(other) == (expected.count(other) == 1));
+}
+
+TEST(Bech32Test, address_table) {
+    const char *path = "test_address_table.b32";
+    std::vector<std::string> addresses = {
+            "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4",
+            "tb1qrp33g0q5c5txsp9arysrx4k6zdkfs4nce4xj0gdcccefvpysxf3q0sl5k7",
+            "bc1pw508d6qejxtdg4y5r3zarvary0c5xw7kw508d6qejxtdg4y5r3zarvary0c5xw7kt5nd6y",
+            "BC1SW50QGDZ25J",
+            "a1lqfn3a"
+    };
+    std::stringstream text;
+    text << addresses[0] << "\n" << addresses[1] << "\r\n\n" << "not an address\n"
+         << addresses[2] << "\n" << addresses[3] << "\n" << addresses[4] << "\n"
+         << "BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4\n";
+    std::vector<size_t> badLines = bech32::convertAddressText(text, path);
+    ASSERT_EQ(badLines, std::vector<size_t>({4}));
+
+    {
+        bech32::AddressTable table(path);
+        // the upper case duplicate is dropped
+        ASSERT_EQ(table.size(), addresses.size());
+        ASSERT_EQ(table.hrps(), std::vector<std::string>({"bc", "tb", "a"}));
+        for (const std::string &address : addresses) {
+            size_t i = table.find(address);
+            ASSERT_NE(i, bech32::AddressTable::npos);
+            ASSERT_EQ(table[i], bech32::decode(address));
+            ASSERT_TRUE(table.contains(bech32::decode(address)));
+        }
+        // records are sorted by HRP id first
+        ASSERT_EQ(table[0].hrp, "bc");
+        ASSERT_EQ(table[table.size() - 1].hrp, "a");
+
+        ASSERT_FALSE(table.contains("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t5"));
+        ASSERT_FALSE(table.contains("bc1qr508d6qejxtdg4y5r3zarvary0c5xw7kw2vd5n"));
+        ASSERT_FALSE(table.contains("a12uel5l"));
+        ASSERT_FALSE(table.contains("xyz1lqfn3a"));
+        ASSERT_FALSE(table.contains("not an address"));
+        bech32::DecodedResult other = bech32::decode(addresses[0]);
+        other.encoding = bech32::Encoding::Bech32m;
+        ASSERT_FALSE(table.contains(other));
+    }
+
+    {
+        bech32::AddressTableWriter writer;
+        ASSERT_THROW(writer.add(bech32::DecodedResult()), std::runtime_error);
+        writer.write(path);
+        bech32::AddressTable empty(path);
+        ASSERT_EQ(empty.size(), 0);
+        ASSERT_FALSE(empty.contains(addresses[0]));
+    }
+
+    {
+        std::ofstream bad(path, std::ios::binary);
+        bad << std::string(64, 'x');
+    }
+    ASSERT_THROW(bech32::AddressTable table(path), std::runtime_error);
+    std::remove(path);
+    ASSERT_THROW(bech32::AddressTable table(path), std::runtime_error);
+}
+
+RC_GTEST_PROP(Bech32TestRC, decodeViewShouldMatchDecode, ()
+) {
+    const auto hrp = *rc::gen::nonEmpty(
+            rc::gen::container<std::string>(
+                    rc::gen::inRange<char>(33, 126)));
+    const auto data =
+            *rc::gen::container<std::vector<unsigned char>>(
+                    *rc::gen::inRange<size_t>(0, 100),
+                    rc::gen::inRange<unsigned char>(0, 31));
+    std::string bstr = *rc::gen::arbitrary<bool>() ?
+            bech32::encode<bech32::UnlimitedLength>(hrp, data) :
+            bech32::encodeUsingOriginalConstant<bech32::UnlimitedLength>(hrp, data);
+
+    // sometimes change a char, which may break the string in any of the ways decode() checks
+    if (*rc::gen::arbitrary<bool>()) {
+        size_t i = *rc::gen::inRange<size_t>(0, bstr.size());
+        bstr[i] = *rc::gen::arbitrary<char>();
+    }
+
+    bech32::DecodedView view = bech32::decodeView(bstr, bech32::limits::UNLIMITED_LENGTH);
+    bech32::Encoding encoding = encodingFromDecode(bstr, bech32::limits::UNLIMITED_LENGTH);
+    RC_ASSERT(view.encoding() == encoding);
+    if (encoding != bech32::Encoding::Invalid) {
+        bech32::DecodedResult expected = bech32::decode(bstr, bech32::limits::UNLIMITED_LENGTH);
+        RC_ASSERT(view.hrp() == expected.hrp);
+        RC_ASSERT(view.dp() == expected.dp);
+        RC_ASSERT(std::vector<unsigned char>(view.begin(), view.end()) == expected.dp);
+    }
+}
+
+// check that transcoding gives the same string as decoding then encoding again
+TEST(Bech32Test, transcode) {
+    std::string bstr = "a1lqfn3a";
+    ASSERT_EQ(bech32::transcode(bstr, "a", bech32::Encoding::Bech32), "a12uel5l");
+    ASSERT_EQ(bech32::transcode("a12uel5l", "a", bech32::Encoding::Bech32m), bstr);
+
+    std::string addr = "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4";
+    bech32::DecodedResult b = bech32::decode(addr);
+    ASSERT_EQ(bech32::transcode(addr, "tb", bech32::Encoding::Bech32),
+              bech32::encodeUsingOriginalConstant("tb", b.dp));
+    ASSERT_EQ(bech32::transcode(addr, "TB", bech32::Encoding::Bech32m),
+              bech32::encode("tb", b.dp));
+    ASSERT_EQ(bech32::transcode(addr, "bc", bech32::Encoding::Bech32), addr);
+
+    // case of the input string is kept
+    std::string upper = "BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4";
+    std::string expected = bech32::encode("tb", b.dp);
+    std::transform(expected.begin(), expected.end(), expected.begin(), ::toupper);
+    ASSERT_EQ(bech32::transcode(upper, "tb", bech32::Encoding::Bech32m), expected);
+
+    std::string inPlace = addr;
+    bech32::transcodeInPlace(inPlace, "tb", bech32::Encoding::Bech32m);
+    ASSERT_EQ(inPlace, bech32::encode("tb", b.dp));
+
+    std::string longStr(bolt11Invoice);
+    bech32::DecodedResult c = bech32::decode<bech32::UnlimitedLength>(longStr);
+    ASSERT_THROW(bech32::transcode(longStr, "lntb", bech32::Encoding::Bech32), std::runtime_error);
+    ASSERT_EQ(bech32::transcode(longStr, "lntb", bech32::Encoding::Bech32, bech32::limits::UNLIMITED_LENGTH),
+              bech32::encodeUsingOriginalConstant<bech32::UnlimitedLength>("lntb", c.dp));
+}
+
+TEST(Bech32Test, transcode_bad) {
+    std::string addr = "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4";
+    ASSERT_THROW(bech32::transcode("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t5", "tb", bech32::Encoding::Bech32),
+                 std::runtime_error);
+    ASSERT_THROW(bech32::transcode("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3tb", "tb", bech32::Encoding::Bech32),
+                 std::runtime_error);
+    ASSERT_THROW(bech32::transcode("1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4", "tb", bech32::Encoding::Bech32),
+                 std::runtime_error);
+    ASSERT_THROW(bech32::transcode(addr, "", bech32::Encoding::Bech32), std::runtime_error);
+    ASSERT_THROW(bech32::transcode(addr, "tb", bech32::Encoding::Invalid), std::runtime_error);
+    ASSERT_THROW(bech32::transcode(addr, std::string(84, 'a'), bech32::Encoding::Bech32), std::runtime_error);
+}
+
+// check that transcoding a batch leaves bad strings as they are, and reports them
+TEST(Bech32Test, transcode_batch) {
+    std::vector<std::string> bstrings = {
+            "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4",
+            "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t5",
+            "a1lqfn3a",
+            "not a bech32 string"};
+    std::vector<std::string> expected = bstrings;
+    expected[0] = bech32::transcode(bstrings[0], "tb", bech32::Encoding::Bech32m);
+    expected[2] = bech32::transcode(bstrings[2], "tb", bech32::Encoding::Bech32m);
+
+    std::vector<size_t> failed = bech32::transcodeInPlace(bstrings, "tb", bech32::Encoding::Bech32m);
+    ASSERT_EQ(failed, std::vector<size_t>({1, 3}));
+    ASSERT_EQ(bstrings, expected);
+}
+
+RC_GTEST_PROP(Bech32TestRC, transcodeShouldMatchDecodeThenEncode, ()
+) {
+    // generate hrps with chars between a-z and 0-9
+    const auto genHrp = rc::gen::nonEmpty(
+            rc::gen::container<std::string>(
+                    rc::gen::oneOf(
+                            rc::gen::inRange('a', 'z'),
+                            rc::gen::inRange('0', '9'))));
+    const auto hrp1 = *genHrp;
+    const auto hrp2 = *genHrp;
+    const auto data =
+            *rc::gen::container<std::vector<unsigned char>>(
+                    *rc::gen::inRange<size_t>(0, 2000),
+                    rc::gen::inRange<unsigned char>(0, 31));
+    const bool toOriginal = *rc::gen::arbitrary<bool>();
+
+    std::string bstr = bech32::encode<bech32::UnlimitedLength>(hrp1, data);
+    std::string ret = bech32::transcode(bstr, hrp2,
+            toOriginal ? bech32::Encoding::Bech32 : bech32::Encoding::Bech32m,
+            bech32::limits::UNLIMITED_LENGTH);
+    if (toOriginal)
+        RC_ASSERT(ret == bech32::encodeUsingOriginalConstant<bech32::UnlimitedLength>(hrp2, data));
+    else
+        RC_ASSERT(ret == bech32::encode<bech32::UnlimitedLength>(hrp2, data));
+}
+
 TEST(Bech32Test, create_checksum) {
     std::string hrp = "a";
     std::vector<unsigned char> data;
@@ -761,6 +2251,147 @@ TEST(Bech32Test, strip_unknown_chars) {
     EXPECT_EQ(bech32::stripUnknownChars("tx1!rjk0\\u5ng*4jsf^^mc"), "tx1rjk0u5ng4jsfmc");
 }
 
+TEST(Bech32Test, strip_unknown_chars_in_place) {
+    std::string bstr = "tx1!rjk0\\u5ng*4jsf^^mc";
+    bech32::stripUnknownCharsInPlace(bstr);
+    EXPECT_EQ(bstr, "tx1rjk0u5ng4jsfmc");
+
+    bstr = "";
+    bech32::stripUnknownCharsInPlace(bstr);
+    EXPECT_EQ(bstr, "");
+}
+
+// the chars kept by stripUnknownChars(), as a straightforward reference for the fast versions
+std::string referenceStripUnknownChars(std::string str) {
+    str.erase(
+            std::remove_if(
+                    str.begin(), str.end(),
+                    [](char x) {
+                        return std::find(std::begin(charset), std::end(charset), ::tolower(x)) == std::end(charset) &&
+                               x != bech32::separator;
+                    }),
+            str.end());
+    return str;
+}
+
+RC_GTEST_PROP(Bech32TestRC, fastStripUnknownCharsMatchesReference, ()
+) {
+    // strings of any char, and strings of mostly valid chars
+    const auto str = *rc::gen::oneOf(
+            rc::gen::container<std::string>(rc::gen::arbitrary<char>()),
+            rc::gen::container<std::string>(
+                    rc::gen::weightedOneOf<char>({
+                            {10, rc::gen::elementOf(std::string("qpzry9x8gf2tvdw0s3jn54khce6mua7lQPZRY9X8GF2TVDW0S3JN54KHCE6MUA7L"))},
+                            {1, rc::gen::arbitrary<char>()}})));
+    const std::string expected = referenceStripUnknownChars(str);
+
+    std::string buf = str;
+    buf.resize(static_cast<size_t>(bech32::simd::stripUnknownCharsScalar(&buf[0], &buf[0] + str.size(), &buf[0]) - &buf[0]));
+    RC_ASSERT(buf == expected);
+
+#ifdef LIBBECH32_HAVE_SSSE3
+    if (bech32::simd::hasSsse3()) {
+        buf = str;
+        buf.resize(static_cast<size_t>(bech32::simd::stripUnknownCharsSsse3(&buf[0], &buf[0] + str.size(), &buf[0]) - &buf[0]));
+        RC_ASSERT(buf == expected);
+
+        // and into a separate buffer
+        std::string out(str.size() + 16, '\0');
+        out.resize(static_cast<size_t>(bech32::simd::stripUnknownCharsSsse3(str.data(), str.data() + str.size(), &out[0]) - &out[0]));
+        RC_ASSERT(out == expected);
+    }
+#endif
+
+    RC_ASSERT(bech32::stripUnknownChars(str) == expected);
+}
+
+RC_GTEST_PROP(Bech32TestRC, fastMapCharsMatchesReference, ()
+) {
+    // strings of mostly charset chars, in either case, sometimes with other chars
+    const auto str = *rc::gen::container<std::string>(
+            rc::gen::weightedOneOf<char>({
+                    {50, rc::gen::elementOf(std::string("qpzry9x8gf2tvdw0s3jn54khce6mua7lQPZRY9X8GF2TVDW0S3JN54KHCE6MUA7L"))},
+                    {1, rc::gen::arbitrary<char>()}}));
+
+    // reference: map until the first char that isn't in the charset
+    std::vector<unsigned char> expected;
+    size_t expectedStop = 0;
+    for (; expectedStop < str.size(); ++expectedStop) {
+        auto c = static_cast<unsigned char>(str[expectedStop]);
+        if (c > REVERSE_CHARSET_SIZE - 1 || reverse_charset[c] == -1)
+            break;
+        expected.push_back(static_cast<unsigned char>(reverse_charset[c]));
+    }
+
+    std::vector<unsigned char> out(str.size());
+    const char *stop = bech32::simd::mapCharsScalar(str.data(), str.data() + str.size(), out.data());
+    RC_ASSERT(static_cast<size_t>(stop - str.data()) == expectedStop);
+    RC_ASSERT(std::equal(expected.begin(), expected.end(), out.begin()));
+
+#ifdef LIBBECH32_HAVE_SSSE3
+    if (bech32::simd::hasSsse3()) {
+        std::vector<unsigned char> out2(str.size());
+        stop = bech32::simd::mapCharsSsse3(str.data(), str.data() + str.size(), out2.data());
+        RC_ASSERT(static_cast<size_t>(stop - str.data()) == expectedStop);
+        RC_ASSERT(std::equal(expected.begin(), expected.end(), out2.begin()));
+    }
+#endif
+}
+
+RC_GTEST_PROP(Bech32TestRC, fastMapValuesMatchesReference, ()
+) {
+    // data values, sometimes out of range
+    const auto values = *rc::gen::container<std::vector<unsigned char>>(
+            rc::gen::weightedOneOf<unsigned char>({
+                    {50, rc::gen::inRange<unsigned char>(0, 31)},
+                    {1, rc::gen::arbitrary<unsigned char>()}}));
+
+    std::string expected;
+    size_t expectedStop = 0;
+    for (; expectedStop < values.size() && values[expectedStop] < 32; ++expectedStop)
+        expected += charset[values[expectedStop]];
+
+    std::string out(values.size(), '\0');
+    const unsigned char *stop = bech32::simd::mapValuesScalar(values.data(), values.data() + values.size(), &out[0]);
+    RC_ASSERT(static_cast<size_t>(stop - values.data()) == expectedStop);
+    RC_ASSERT(out.substr(0, expectedStop) == expected);
+
+#ifdef LIBBECH32_HAVE_SSSE3
+    if (bech32::simd::hasSsse3()) {
+        std::string out2(values.size(), '\0');
+        stop = bech32::simd::mapValuesSsse3(values.data(), values.data() + values.size(), &out2[0]);
+        RC_ASSERT(static_cast<size_t>(stop - values.data()) == expectedStop);
+        RC_ASSERT(out2.substr(0, expectedStop) == expected);
+    }
+#endif
+}
+
+RC_GTEST_PROP(Bech32TestRC, regroupingShouldMatchPacking, ()
+) {
+    const auto groups = *rc::gen::inRange<size_t>(0, 40);
+    const auto bytes = *rc::gen::container<std::vector<unsigned char>>(5 * groups, rc::gen::arbitrary<unsigned char>());
+
+    std::vector<unsigned char> expected(8 * groups);
+    bech32::packing::unpackValues(bytes.data(), 8 * groups, expected.data());
+    std::vector<unsigned char> values(8 * groups);
+    bech32::simd::unpackGroupsScalar(bytes.data(), groups, values.data());
+    RC_ASSERT(values == expected);
+    std::vector<unsigned char> packed(5 * groups);
+    bech32::simd::packGroupsScalar(values.data(), groups, packed.data());
+    RC_ASSERT(packed == bytes);
+
+#ifdef LIBBECH32_HAVE_SSSE3
+    if (bech32::simd::hasSsse3()) {
+        std::vector<unsigned char> values2(8 * groups);
+        bech32::simd::unpackGroupsSsse3(bytes.data(), groups, values2.data());
+        RC_ASSERT(values2 == expected);
+        std::vector<unsigned char> packed2(5 * groups);
+        bech32::simd::packGroupsSsse3(values.data(), groups, packed2.data());
+        RC_ASSERT(packed2 == bytes);
+    }
+#endif
+}
+
 RC_GTEST_PROP(Bech32TestRC, acceptDataValuesInRange, ()
 ) {
     // generate string to be used as data. Restrict the values of the generated
@@ -0,0 +1,83 @@
+#include "bech32_ranges.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <forward_list>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+    const std::vector<std::string> strings = {
+            "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4",
+            "not an address",
+            "bc1p0xlxvlhemja6c4dqv22uapctqupfhlxm9h8z3k2e72q4k9hcz7vqzk5jj0",
+            "A1LQFN3A",
+            "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t5"};
+
+}
+
+// views of temporary strings would dangle
+static_assert(!std::is_invocable_v<bech32::views::DecodeString, std::string &&>);
+static_assert(std::is_invocable_v<bech32::views::DecodeString, const std::string &>);
+static_assert(std::is_invocable_v<bech32::views::DecodeString, const char *>);
+
+// the default limits are a constant
+static_assert(bech32::limits::STANDARD_LENGTH.maxBech32Length == bech32::limits::MAX_BECH32_LENGTH);
+
+TEST(Bech32RangesTest, decode_matches_decode_view) {
+    std::vector<bech32::Encoding> encodings;
+    for (bech32::DecodedView view : strings | bech32::views::decode) {
+        encodings.push_back(view.encoding());
+    }
+    ASSERT_EQ(encodings, std::vector<bech32::Encoding>({bech32::Encoding::Bech32, bech32::Encoding::Invalid,
+                                                        bech32::Encoding::Bech32m, bech32::Encoding::Bech32m,
+                                                        bech32::Encoding::Invalid}));
+
+    auto views = strings | bech32::views::decode;
+    auto it = std::ranges::begin(views);
+    ASSERT_EQ((*it).hrp(), "bc");
+    ASSERT_EQ((*it).dp(), bech32::decode(strings[0]).dp);
+    // the views refer to the strings of the range
+    ASSERT_EQ((*it).hrpData(), strings[0].data());
+}
+
+TEST(Bech32RangesTest, filters) {
+    std::vector<std::string> hrps;
+    for (bech32::DecodedView view : strings | bech32::views::decode | bech32::views::valid)
+        hrps.push_back(view.hrp());
+    ASSERT_EQ(hrps, std::vector<std::string>({"bc", "bc", "a"}));
+
+    auto taproot = strings | bech32::views::decode | bech32::views::withEncoding(bech32::Encoding::Bech32m)
+                   | std::views::filter([](const bech32::DecodedView &view) { return view.hrp() == "bc"; });
+    ASSERT_EQ(std::ranges::distance(taproot), 1);
+    ASSERT_EQ((*std::ranges::begin(taproot))[0], 1);
+}
+
+TEST(Bech32RangesTest, other_ranges) {
+    // string views, a lazily read stream, and other length limits
+    std::vector<std::string_view> stringViews(strings.begin(), strings.end());
+    ASSERT_EQ(std::ranges::distance(stringViews | bech32::views::decode | bech32::views::valid), 3);
+
+    std::vector<const char *> cStrings;
+    for (const std::string &bstr : strings)
+        cStrings.push_back(bstr.c_str());
+    ASSERT_EQ(std::ranges::distance(cStrings | bech32::views::decode | bech32::views::valid), 3);
+
+    std::istringstream lines("a12uel5l\nnope\nA12UEL5L\n");
+    size_t valid = 0;
+    for (bech32::DecodedView view : std::views::istream<std::string>(lines) | bech32::views::decode) {
+        valid += view.encoding() == bech32::Encoding::Bech32;
+    }
+    ASSERT_EQ(valid, 2);
+
+    std::forward_list<std::string> longStrings = {
+            bech32::encode("a", std::vector<unsigned char>(200, 3), bech32::limits::UNLIMITED_LENGTH)};
+    ASSERT_EQ(std::ranges::distance(longStrings | bech32::views::decode | bech32::views::valid), 0);
+    ASSERT_EQ(std::ranges::distance(longStrings | bech32::views::decodeWithin(bech32::limits::UNLIMITED_LENGTH)
+                                    | bech32::views::valid), 1);
+}